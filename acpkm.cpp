@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cstring>
+#include "acpkm.hpp"
+#include "omac.hpp"
+
+static block128 acpkm_const(uint8_t first) {
+    std::array<uint8_t, 16> a;
+    for (size_t i = 0; i < 16; i++) {
+        a[i] = static_cast<uint8_t>(first + i);
+    }
+    return {a};
+}
+
+static void increment_counter(block128 &ctr) {
+    for (size_t i = 15; i >= 8; i--) {
+        if (++ctr.a[i] != 0) {
+            break;
+        }
+    }
+}
+
+ctr_acpkm::ctr_acpkm(kuznyechik &cipher, std::pair<block128, block128> key, uint64_t iv, std::size_t section_blocks)
+        : cipher(cipher), counter(uint64_t{0}), section_blocks(section_blocks) {
+    store_be64(counter.a.data(), iv);
+    cipher.expand_key(key, keys);
+}
+
+// The key of a section is only derived once its first block is needed.
+void ctr_acpkm::next_section() {
+    block128 d[2] = {acpkm_const(0x80), acpkm_const(0x90)};
+    cipher.encrypt_blocks(d, 2, keys);
+    cipher.expand_key({d[0], d[1]}, keys);
+    section_pos = 0;
+}
+
+void ctr_acpkm::keystream(block128* out, std::size_t count) {
+    while (count > 0) {
+        if (section_blocks == 0) {
+            for (std::size_t i = 0; i < count; i++) {
+                out[i] = counter;
+                increment_counter(counter);
+            }
+            cipher.encrypt_blocks(out, count, keys);
+            return;
+        }
+        if (section_pos == section_blocks) {
+            next_section();
+        }
+        std::size_t n = std::min(count, section_blocks - section_pos);
+        for (std::size_t i = 0; i < n; i++) {
+            out[i] = counter;
+            increment_counter(counter);
+        }
+        cipher.encrypt_blocks(out, n, keys);
+
+        section_pos += n;
+        out += n;
+        count -= n;
+    }
+}
+
+void ctr_acpkm::apply(block128* data, std::size_t count) {
+    block128 gamma[kuznyechik::BATCH_BLOCKS];
+    while (count > 0) {
+        std::size_t n = std::min(count, kuznyechik::BATCH_BLOCKS);
+        keystream(gamma, n);
+        for (std::size_t i = 0; i < n; i++) {
+            cipher.X_k(data[i], gamma[i]);
+        }
+        data += n;
+        count -= n;
+    }
+}
+
+omac_acpkm::omac_acpkm(kuznyechik &cipher, std::pair<block128, block128> key,
+                       std::size_t section_blocks, std::size_t master_section_blocks)
+        : cipher(cipher), master(cipher, key, UINT64_MAX, master_section_blocks),
+          chain(uint64_t{0}), buffer(uint64_t{0}), section_blocks(section_blocks) {
+    next_section();
+}
+
+void omac_acpkm::next_section() {
+    block128 material[3];
+    master.keystream(material, 3);
+    cipher.expand_key({material[0], material[1]}, keys);
+    k1 = material[2];
+    section_pos = 0;
+}
+
+void omac_acpkm::absorb(block128 &block) {
+    cipher.X_k(chain, block);
+    cipher.encrypt(chain, keys);
+    // the final block is held back, so a following one always exists here
+    if (section_blocks != 0 && ++section_pos == section_blocks) {
+        next_section();
+    }
+}
+
+void omac_acpkm::update(const uint8_t* data, std::size_t len) {
+    while (len > 0) {
+        // the last block is held back until finalize, it is masked with K*
+        if (buffered == 16) {
+            absorb(buffer);
+            buffered = 0;
+        }
+        std::size_t n = std::min(len, 16 - buffered);
+        std::memcpy(buffer.a.data() + buffered, data, n);
+        buffered += n;
+        data += n;
+        len -= n;
+    }
+}
+
+block128 omac_acpkm::finalize() {
+    block128 key_star = k1;
+    if (buffered < 16) {
+        std::fill(buffer.a.begin() + buffered, buffer.a.end(), 0);
+        buffer.a[buffered] = 0x80;
+        omac::double_block(key_star);
+    }
+    cipher.X_k(chain, buffer);
+    cipher.X_k(chain, key_star);
+    cipher.encrypt(chain, keys);
+    return chain;
+}
@@ -1,7 +1,9 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#if defined(__ARM_NEON)
 #include <arm_neon.h>
+#endif
 
 #include "block128.hpp"
 
@@ -11,9 +13,7 @@ block128::block128(std::array<uint8_t, 16>& a) : a(a) {}
 
 block128::block128(uint64_t num) {
     a.fill(0);
-    for (size_t i = 0; i < 8; ++i) {
-        a[i + 8] = static_cast<uint8_t>((num >> (56 - i * 8)) & 0xFF); // Extract each byte
-    }
+    store_be64(a.data() + 8, num);
 }
 
 block128::block128(std::string s) {
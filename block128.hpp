@@ -4,7 +4,9 @@
 #include <string>
 #include <cstring>
 #include <array>
+#if defined(__ARM_NEON)
 #include <arm_neon.h>
+#endif
 
 
 struct block128 {
@@ -22,3 +24,33 @@ struct block128 {
 
     std::string to_string();
 };
+
+// Big-endian loads and stores, the byte order blocks, counters and length
+// fields use throughout. Inline, since MGM calls them for every block.
+inline uint64_t load_be64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (std::size_t i = 0; i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+inline void store_be64(uint8_t* p, uint64_t v) {
+    for (std::size_t i = 0; i < 8; i++) {
+        p[i] = static_cast<uint8_t>(v >> (56 - i * 8));
+    }
+}
+
+inline uint32_t load_be32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (std::size_t i = 0; i < 4; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+inline void store_be32(uint8_t* p, uint32_t v) {
+    for (std::size_t i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (24 - i * 8));
+    }
+}
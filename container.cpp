@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "container.hpp"
+#include "acpkm.hpp"
+#include "omac.hpp"
+#include "iov.hpp"
+#include "mgm.hpp"
+
+static const uint8_t CONTAINER_MAGIC[4] = {'K', 'U', 'Z', 'C'};
+static constexpr uint8_t CONTAINER_VERSION = 2;
+
+// Runs f(begin, end) over count items split into contiguous ranges, one per thread.
+template <typename F>
+static void parallel_for(std::size_t count, std::size_t threads, F f) {
+    threads = std::max<std::size_t>(1, std::min(threads, count));
+    std::vector<std::thread> workers;
+    std::size_t per_thread = (count + threads - 1) / threads;
+    for (std::size_t begin = per_thread; begin < count; begin += per_thread) {
+        workers.emplace_back(f, begin, std::min(count, begin + per_thread));
+    }
+    f(0, std::min(count, per_thread));
+    for (auto &w: workers) {
+        w.join();
+    }
+}
+
+container_params::container_params(kuznyechik &cipher, std::pair<block128, block128> key, chunk_mode mode,
+                                   uint32_t chunk_size, block128 nonce)
+        : cipher(cipher), key(key), mode(mode), chunk_size(chunk_size), nonce(nonce) {
+    std::memset(header, 0, HEADER_SIZE);
+    std::memcpy(header, CONTAINER_MAGIC, 4);
+    header[4] = CONTAINER_VERSION;
+    header[5] = mode;
+    store_be32(header + 8, chunk_size);
+    std::memcpy(header + 16, nonce.a.data(), 16);
+
+    // The container key is the encryption of the whole nonce masked with two
+    // constants, so distinct nonces never share chunk keystream or MGM nonces.
+    // The OMAC key is derived from it the same way from the constants alone.
+    block128 keys[11];
+    std::array<uint8_t, 16> c1, c2;
+    c1.fill(0xa5);
+    c2.fill(0x5a);
+    block128 d1(c1), d2(c2);
+    cipher.expand_key(key, keys);
+    chunk_key = {nonce, nonce};
+    cipher.X_k(chunk_key.first, d1);
+    cipher.X_k(chunk_key.second, d2);
+    cipher.encrypt(chunk_key.first, keys);
+    cipher.encrypt(chunk_key.second, keys);
+
+    cipher.expand_key(chunk_key, keys);
+    mac_key = {d1, d2};
+    cipher.encrypt(mac_key.first, keys);
+    cipher.encrypt(mac_key.second, keys);
+}
+
+bool container_params::seal(uint64_t index, bool final, uint8_t* data, std::size_t len, uint8_t* tag,
+                            bool encrypting) {
+    uint8_t aad[HEADER_SIZE + 9];
+    std::memcpy(aad, header, HEADER_SIZE);
+    store_be64(aad + HEADER_SIZE, index);
+    aad[HEADER_SIZE + 8] = final;
+
+    block128 expected;
+    if (mode == MGM) {
+        mgm aead(cipher, chunk_key);
+        aead.start(block128(index));
+        aead.update_aad(aad, sizeof(aad));
+        if (encrypting) {
+            aead.encrypt(data, data, len);
+        } else {
+            aead.decrypt(data, data, len);
+        }
+        expected = aead.finalize();
+    } else {
+        omac mac(cipher, mac_key);
+        ctr_acpkm ctr(cipher, chunk_key, index, 0);
+        iov_ctr stream(ctr);
+        iovec io = {data, len};
+        mac.update(aad, sizeof(aad));
+        if (encrypting) {
+            stream.apply(&io, 1, &io, 1);
+        }
+        mac.update(data, len);
+        expected = mac.finalize();
+        if (!encrypting) {
+            stream.apply(&io, 1, &io, 1);
+        }
+    }
+
+    if (encrypting) {
+        std::memcpy(tag, expected.a.data(), TAG_SIZE);
+        return true;
+    }
+    uint8_t diff = 0;
+    for (std::size_t i = 0; i < TAG_SIZE; i++) {
+        diff |= expected.a[i] ^ tag[i];
+    }
+    if (diff != 0) {
+        std::memset(data, 0, len);
+        return false;
+    }
+    return true;
+}
+
+container_writer::container_writer(std::ostream &out, kuznyechik &cipher, std::pair<block128, block128> key,
+                                   container_params::chunk_mode mode, uint32_t chunk_size, block128 nonce,
+                                   std::size_t threads)
+        : out(out), params(cipher, key, mode, chunk_size, nonce), threads(std::max<std::size_t>(1, threads)) {
+    pending.reserve(this->threads * chunk_size + 1);
+    out.write(reinterpret_cast<const char*>(params.header), container_params::HEADER_SIZE);
+}
+
+bool container_writer::write(const uint8_t* data, std::size_t len) {
+    if (finished) {
+        return false;
+    }
+    // at most one batch is buffered, and at least one byte is kept back since
+    // the final chunk is only known in finish
+    std::size_t batch = threads * params.chunk_size;
+    while (len > 0) {
+        std::size_t n = std::min(len, batch + 1 - pending.size());
+        pending.insert(pending.end(), data, data + n);
+        data += n;
+        len -= n;
+        if (pending.size() > batch) {
+            flush(batch, false);
+        }
+    }
+    return true;
+}
+
+bool container_writer::finish() {
+    if (finished) {
+        return false;
+    }
+    flush(pending.size(), true);
+    out.flush();
+    finished = true;
+    return true;
+}
+
+void container_writer::flush(std::size_t len, bool last) {
+    std::size_t cs = params.chunk_size;
+    std::size_t count = std::max<std::size_t>(last ? 1 : 0, (len + cs - 1) / cs);
+    std::vector<uint8_t> sealed(len + count * container_params::TAG_SIZE);
+
+    parallel_for(count, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            std::size_t n = std::min(cs, len - i * cs);
+            uint8_t* chunk = sealed.data() + i * (cs + container_params::TAG_SIZE);
+            std::memcpy(chunk, pending.data() + i * cs, n);
+            params.seal(chunks_written + i, last && i + 1 == count, chunk, n, chunk + n, true);
+        }
+    });
+
+    out.write(reinterpret_cast<const char*>(sealed.data()), sealed.size());
+    pending.erase(pending.begin(), pending.begin() + len);
+    chunks_written += count;
+}
+
+container_reader::container_reader(std::istream &in, kuznyechik &cipher, std::pair<block128, block128> key,
+                                   std::size_t threads)
+        : in(in), cipher(cipher), key(key), threads(std::max<std::size_t>(1, threads)) {
+    uint8_t header[container_params::HEADER_SIZE];
+    in.seekg(0, std::ios::end);
+    uint64_t file_size = in.tellg();
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        std::memcmp(header, CONTAINER_MAGIC, 4) != 0 || header[4] != CONTAINER_VERSION ||
+        header[5] > container_params::MGM) {
+        return;
+    }
+    uint32_t chunk_size = load_be32(header + 8);
+    if (chunk_size == 0) {
+        return;
+    }
+
+    uint64_t body = file_size - container_params::HEADER_SIZE;
+    uint64_t stored_chunk = chunk_size + container_params::TAG_SIZE;
+    uint64_t rest = body % stored_chunk;
+    if (rest != 0 && rest < container_params::TAG_SIZE) {
+        return;
+    }
+    chunks = body / stored_chunk + (rest != 0);
+    if (chunks == 0) {
+        return;
+    }
+    plaintext_size = body - chunks * container_params::TAG_SIZE;
+
+    block128 nonce;
+    std::memcpy(nonce.a.data(), header + 16, 16);
+    params.reset(new container_params(cipher, key, static_cast<container_params::chunk_mode>(header[5]),
+                                      chunk_size, nonce));
+}
+
+bool container_reader::valid() {
+    return params != nullptr;
+}
+
+uint64_t container_reader::size() {
+    return plaintext_size;
+}
+
+bool container_reader::read(uint64_t offset, std::size_t len, uint8_t* out) {
+    if (!valid() || offset > plaintext_size || len > plaintext_size - offset) {
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+    uint64_t cs = params->chunk_size;
+    uint64_t stored_chunk = cs + container_params::TAG_SIZE;
+    uint64_t first = offset / cs;
+    uint64_t last = (offset + len - 1) / cs;
+    std::size_t count = last - first + 1;
+
+    uint64_t raw_begin = container_params::HEADER_SIZE + first * stored_chunk;
+    uint64_t raw_end = std::min<uint64_t>(container_params::HEADER_SIZE + (last + 1) * stored_chunk,
+                                          container_params::HEADER_SIZE + plaintext_size +
+                                          chunks * container_params::TAG_SIZE);
+    std::vector<uint8_t> raw(raw_end - raw_begin);
+    in.clear();
+    in.seekg(raw_begin);
+    if (!in.read(reinterpret_cast<char*>(raw.data()), raw.size())) {
+        return false;
+    }
+
+    std::vector<uint8_t> ok(count, 0);
+    parallel_for(count, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            uint64_t index = first + i;
+            std::size_t n = std::min<uint64_t>(cs, plaintext_size - index * cs);
+            uint8_t* chunk = raw.data() + i * stored_chunk;
+            ok[i] = params->seal(index, index + 1 == chunks, chunk, n, chunk + n, false);
+        }
+    });
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < count && len > 0; i++) {
+        uint64_t chunk_begin = (first + i) * cs;
+        std::size_t from = offset > chunk_begin ? offset - chunk_begin : 0;
+        std::size_t n = std::min<uint64_t>(len, std::min<uint64_t>(cs, plaintext_size - chunk_begin) - from);
+        std::memcpy(out, raw.data() + i * stored_chunk + from, n);
+        out += n;
+        offset += n;
+        len -= n;
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <istream>
+#include <ostream>
+#include "kuznyechik.hpp"
+#include "block128.hpp"
+
+// Chunked container with random access:
+//   header  32 bytes: "KUZC", version, mode, 2 zero bytes, chunk size (u32 BE),
+//           4 zero bytes, 16 byte nonce
+//   chunks  chunk_size bytes of ciphertext (the last one may be shorter)
+//           followed by a 16 byte tag
+// Chunks are encrypted under a per-container key E_K(N ^ D1) || E_K(N ^ D2)
+// derived from all 16 nonce bytes, so the nonce has to be unique per key (a
+// random one is). Chunk i of a CTR container uses i as IV and is
+// authenticated by OMAC under a key derived from the container key, MGM uses
+// i as nonce. Both authenticate the header, the chunk index and a final-chunk
+// flag, so truncating the file on a chunk boundary or reordering chunks fails
+// the tag check.
+// Chunks are encrypted and decrypted in parallel; the stream is only used by
+// the calling thread.
+struct container_params {
+    enum chunk_mode : uint8_t { CTR_OMAC = 0, MGM = 1 };
+
+    static constexpr std::size_t HEADER_SIZE = 32;
+    static constexpr std::size_t TAG_SIZE = 16;
+
+    container_params(kuznyechik &cipher, std::pair<block128, block128> key, chunk_mode mode,
+                     uint32_t chunk_size, block128 nonce);
+
+    // Encrypts data in place and writes its tag, or checks the tag and
+    // decrypts. Keeps no state between calls, so chunks can be sealed from
+    // several threads at once.
+    bool seal(uint64_t index, bool final, uint8_t* data, std::size_t len, uint8_t* tag, bool encrypting);
+
+    kuznyechik &cipher;
+    std::pair<block128, block128> key;
+    std::pair<block128, block128> chunk_key;
+    std::pair<block128, block128> mac_key;
+    chunk_mode mode;
+    uint32_t chunk_size;
+    block128 nonce;
+    uint8_t header[HEADER_SIZE];
+};
+
+struct container_writer {
+    container_writer(std::ostream &out, kuznyechik &cipher, std::pair<block128, block128> key,
+                     container_params::chunk_mode mode, uint32_t chunk_size, block128 nonce,
+                     std::size_t threads);
+
+    // Both fail once finish has sealed the final chunk.
+    bool write(const uint8_t* data, std::size_t len);
+    bool finish();
+
+    std::ostream &out;
+    container_params params;
+    std::size_t threads;
+    std::vector<uint8_t> pending;
+    uint64_t chunks_written = 0;
+    bool finished = false;
+
+private:
+    void flush(std::size_t len, bool last);
+};
+
+struct container_reader {
+    container_reader(std::istream &in, kuznyechik &cipher, std::pair<block128, block128> key,
+                     std::size_t threads);
+
+    bool valid();
+    uint64_t size();
+    bool read(uint64_t offset, std::size_t len, uint8_t* out);
+
+    std::istream &in;
+    kuznyechik &cipher;
+    std::pair<block128, block128> key;
+    std::size_t threads;
+    std::unique_ptr<container_params> params;
+    uint64_t chunks = 0;
+    uint64_t plaintext_size = 0;
+};
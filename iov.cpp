@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstring>
+#include "iov.hpp"
+
+static constexpr std::size_t IOV_BATCH_BLOCKS = 4 * kuznyechik::BATCH_BLOCKS;
+
+iov_cursor::iov_cursor(const iovec* iov, std::size_t count) : iov(iov), count(count) {}
+
+std::size_t iov_cursor::contiguous() {
+    while (count > 0 && offset == iov->iov_len) {
+        iov++;
+        count--;
+        offset = 0;
+    }
+    return count > 0 ? iov->iov_len - offset : 0;
+}
+
+uint8_t* iov_cursor::data() {
+    return static_cast<uint8_t*>(iov->iov_base) + offset;
+}
+
+void iov_cursor::advance(std::size_t n) {
+    offset += n;
+}
+
+void iov_cursor::read(uint8_t* dst, std::size_t n) {
+    while (n > 0) {
+        std::size_t m = std::min(n, contiguous());
+        std::memcpy(dst, data(), m);
+        advance(m);
+        dst += m;
+        n -= m;
+    }
+}
+
+void iov_cursor::write(const uint8_t* src, std::size_t n) {
+    while (n > 0) {
+        std::size_t m = std::min(n, contiguous());
+        std::memcpy(data(), src, m);
+        advance(m);
+        src += m;
+        n -= m;
+    }
+}
+
+std::size_t iov_cursor::total(const iovec* iov, std::size_t count) {
+    std::size_t len = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        len += iov[i].iov_len;
+    }
+    return len;
+}
+
+static void xor_bytes(uint8_t* dst, const uint8_t* src, const uint8_t* gamma, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        dst[i] = src[i] ^ gamma[i];
+    }
+}
+
+iov_ctr::iov_ctr(ctr_acpkm &ctr) : ctr(ctr) {}
+
+bool iov_ctr::apply(const iovec* in, std::size_t in_count, const iovec* out, std::size_t out_count) {
+    std::size_t left = iov_cursor::total(in, in_count);
+    if (left != iov_cursor::total(out, out_count)) {
+        return false;
+    }
+
+    iov_cursor src(in, in_count);
+    iov_cursor dst(out, out_count);
+    block128 batch[IOV_BATCH_BLOCKS];
+    while (left > 0) {
+        std::size_t run = std::min(src.contiguous(), dst.contiguous());
+        if (gamma_used < 16) {
+            std::size_t n = std::min(run, 16 - gamma_used);
+            xor_bytes(dst.data(), src.data(), gamma.a.data() + gamma_used, n);
+            gamma_used += n;
+            src.advance(n);
+            dst.advance(n);
+            left -= n;
+        } else if (run >= 16) {
+            std::size_t blocks = std::min(run / 16, IOV_BATCH_BLOCKS);
+            ctr.keystream(batch, blocks);
+            for (std::size_t i = 0; i < blocks; i++) {
+                xor_bytes(dst.data(), src.data(), batch[i].a.data(), 16);
+                src.advance(16);
+                dst.advance(16);
+            }
+            left -= blocks * 16;
+        } else {
+            ctr.keystream(&gamma, 1);
+            gamma_used = 0;
+        }
+    }
+    return true;
+}
+
+iov_cbc::iov_cbc(kuznyechik &cipher, std::pair<block128, block128> key, block128 iv)
+        : cipher(cipher), chain(iv) {
+    cipher.expand_key(key, keys);
+    cipher.expand_decryption_keys(keys, dec_keys);
+}
+
+bool iov_cbc::encrypt(const iovec* in, std::size_t in_count, const iovec* out, std::size_t out_count) {
+    std::size_t left = iov_cursor::total(in, in_count);
+    if (left % 16 != 0 || left != iov_cursor::total(out, out_count)) {
+        return false;
+    }
+
+    iov_cursor src(in, in_count);
+    iov_cursor dst(out, out_count);
+    block128 block;
+    for (; left > 0; left -= 16) {
+        src.read(block.a.data(), 16);
+        cipher.X_k(chain, block);
+        cipher.encrypt(chain, keys);
+        dst.write(chain.a.data(), 16);
+    }
+    return true;
+}
+
+bool iov_cbc::decrypt(const iovec* in, std::size_t in_count, const iovec* out, std::size_t out_count) {
+    std::size_t left = iov_cursor::total(in, in_count);
+    if (left % 16 != 0 || left != iov_cursor::total(out, out_count)) {
+        return false;
+    }
+
+    iov_cursor src(in, in_count);
+    iov_cursor dst(out, out_count);
+    block128 cipher_blocks[IOV_BATCH_BLOCKS];
+    block128 plain_blocks[IOV_BATCH_BLOCKS];
+    while (left > 0) {
+        std::size_t blocks = std::min(left / 16, IOV_BATCH_BLOCKS);
+        for (std::size_t i = 0; i < blocks; i++) {
+            src.read(cipher_blocks[i].a.data(), 16);
+            plain_blocks[i] = cipher_blocks[i];
+        }
+        cipher.decrypt_blocks(plain_blocks, blocks, keys, dec_keys);
+        for (std::size_t i = 0; i < blocks; i++) {
+            cipher.X_k(plain_blocks[i], chain);
+            chain = cipher_blocks[i];
+            dst.write(plain_blocks[i].a.data(), 16);
+        }
+        left -= blocks * 16;
+    }
+    return true;
+}
+
+void omac_update(omac &mac, const iovec* in, std::size_t in_count) {
+    for (std::size_t i = 0; i < in_count; i++) {
+        mac.update(static_cast<const uint8_t*>(in[i].iov_base), in[i].iov_len);
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <sys/uio.h>
+#include "kuznyechik.hpp"
+#include "block128.hpp"
+#include "acpkm.hpp"
+#include "omac.hpp"
+
+// Position in an iovec list, segment boundaries need not be block aligned.
+struct iov_cursor {
+    iov_cursor(const iovec* iov, std::size_t count);
+
+    std::size_t contiguous();
+    uint8_t* data();
+    void advance(std::size_t n);
+    void read(uint8_t* dst, std::size_t n);
+    void write(const uint8_t* src, std::size_t n);
+
+    static std::size_t total(const iovec* iov, std::size_t count);
+
+    const iovec* iov;
+    std::size_t count;
+    std::size_t offset = 0;
+};
+
+// Scatter-gather CTR (or CTR-ACPKM) on top of a ctr_acpkm keystream. Runs of
+// whole blocks inside a segment are encrypted in place from the keystream
+// batch, blocks straddling a boundary use the carried gamma block. Calls can
+// be chained, the unused part of gamma is kept for the next one.
+struct iov_ctr {
+    explicit iov_ctr(ctr_acpkm &ctr);
+
+    bool apply(const iovec* in, std::size_t in_count, const iovec* out, std::size_t out_count);
+
+    ctr_acpkm &ctr;
+    block128 gamma;
+    std::size_t gamma_used = 16;
+};
+
+// Scatter-gather CBC. Each call must cover whole blocks, the chaining value
+// is kept between calls. Blocks are gathered into a small batch buffer, so
+// decryption still goes through decrypt_blocks.
+struct iov_cbc {
+    iov_cbc(kuznyechik &cipher, std::pair<block128, block128> key, block128 iv);
+
+    bool encrypt(const iovec* in, std::size_t in_count, const iovec* out, std::size_t out_count);
+    bool decrypt(const iovec* in, std::size_t in_count, const iovec* out, std::size_t out_count);
+
+    kuznyechik &cipher;
+    block128 keys[11];
+    block128 dec_keys[11];
+    block128 chain;
+};
+
+void omac_update(omac &mac, const iovec* in, std::size_t in_count);
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cstring>
+#include "kexp15.hpp"
+
+kexp15::kexp15(kuznyechik &cipher, std::pair<block128, block128> mac_key, std::pair<block128, block128> enc_key)
+        : cipher(cipher), mac(cipher, mac_key) {
+    cipher.expand_key(enc_key, enc_keys);
+}
+
+// IV || K is 40 bytes: two full blocks and a padded one masked with K2.
+void kexp15::mac_batch(std::pair<block128, block128>* keys, uint64_t* ivs, block128* tags, std::size_t count) {
+    uint8_t msg[kuznyechik::BATCH_BLOCKS][48];
+    for (std::size_t j = 0; j < count; j++) {
+        store_be64(msg[j], ivs[j]);
+        std::memcpy(msg[j] + 8, keys[j].first.a.data(), 16);
+        std::memcpy(msg[j] + 24, keys[j].second.a.data(), 16);
+        std::memset(msg[j] + 40, 0, 8);
+        msg[j][40] = 0x80;
+        tags[j].a.fill(0);
+    }
+    for (std::size_t b = 0; b < 3; b++) {
+        for (std::size_t j = 0; j < count; j++) {
+            for (std::size_t i = 0; i < 16; i++) {
+                tags[j].a[i] ^= msg[j][b * 16 + i];
+            }
+            if (b == 2) {
+                cipher.X_k(tags[j], mac.k2);
+            }
+        }
+        cipher.encrypt_blocks(tags, count, mac.keys);
+    }
+}
+
+// CTR over K || CEK_MAC, three blocks per key with counters IV || 0..2.
+void kexp15::ctr_batch(block128* data, uint64_t* ivs, std::size_t count) {
+    block128 gamma[3 * kuznyechik::BATCH_BLOCKS];
+    for (std::size_t j = 0; j < count; j++) {
+        for (std::size_t b = 0; b < 3; b++) {
+            block128 &ctr = gamma[3 * j + b];
+            ctr.a.fill(0);
+            store_be64(ctr.a.data(), ivs[j]);
+            ctr.a[15] = static_cast<uint8_t>(b);
+        }
+    }
+    cipher.encrypt_blocks(gamma, 3 * count, enc_keys);
+    for (std::size_t i = 0; i < 3 * count; i++) {
+        cipher.X_k(data[i], gamma[i]);
+    }
+}
+
+void kexp15::wrap(std::pair<block128, block128>* keys, uint64_t* ivs, wrapped_key* out, std::size_t count) {
+    for (std::size_t n = 0; n < count; n += kuznyechik::BATCH_BLOCKS) {
+        std::size_t batch = std::min(count - n, kuznyechik::BATCH_BLOCKS);
+        block128 tags[kuznyechik::BATCH_BLOCKS];
+        block128 data[3 * kuznyechik::BATCH_BLOCKS];
+
+        mac_batch(keys + n, ivs + n, tags, batch);
+        for (std::size_t j = 0; j < batch; j++) {
+            data[3 * j] = keys[n + j].first;
+            data[3 * j + 1] = keys[n + j].second;
+            data[3 * j + 2] = tags[j];
+        }
+        ctr_batch(data, ivs + n, batch);
+        for (std::size_t j = 0; j < batch; j++) {
+            out[n + j] = {data[3 * j], data[3 * j + 1], data[3 * j + 2]};
+        }
+    }
+}
+
+// Returns the number of keys whose MAC matched, keys that failed are zeroed.
+std::size_t kexp15::unwrap(wrapped_key* wrapped, uint64_t* ivs, std::pair<block128, block128>* out,
+                           bool* valid, std::size_t count) {
+    std::size_t valid_count = 0;
+    for (std::size_t n = 0; n < count; n += kuznyechik::BATCH_BLOCKS) {
+        std::size_t batch = std::min(count - n, kuznyechik::BATCH_BLOCKS);
+        block128 tags[kuznyechik::BATCH_BLOCKS];
+        block128 data[3 * kuznyechik::BATCH_BLOCKS];
+
+        for (std::size_t j = 0; j < batch; j++) {
+            data[3 * j] = wrapped[n + j][0];
+            data[3 * j + 1] = wrapped[n + j][1];
+            data[3 * j + 2] = wrapped[n + j][2];
+        }
+        ctr_batch(data, ivs + n, batch);
+        for (std::size_t j = 0; j < batch; j++) {
+            out[n + j] = {data[3 * j], data[3 * j + 1]};
+        }
+        mac_batch(out + n, ivs + n, tags, batch);
+
+        for (std::size_t j = 0; j < batch; j++) {
+            uint8_t diff = 0;
+            for (std::size_t i = 0; i < 16; i++) {
+                diff |= tags[j].a[i] ^ data[3 * j + 2].a[i];
+            }
+            valid[n + j] = diff == 0;
+            if (diff != 0) {
+                out[n + j].first.a.fill(0);
+                out[n + j].second.a.fill(0);
+            } else {
+                valid_count++;
+            }
+        }
+    }
+    return valid_count;
+}
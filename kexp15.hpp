@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <array>
+#include "kuznyechik.hpp"
+#include "block128.hpp"
+#include "omac.hpp"
+
+// KExp15/KImp15 key export from R 1323565.1.017:
+//   CEK_MAC = OMAC_{K_MAC}(IV || K), KExp15 = CTR_{K_ENC}(IV, K || CEK_MAC)
+// for 256-bit keys K and 64-bit IVs. Keys are processed BATCH_BLOCKS at a
+// time, so the OMAC chains of a batch and all of its CTR blocks go through
+// encrypt_blocks together instead of one block per call.
+struct kexp15 {
+    using wrapped_key = std::array<block128, 3>;
+
+    kexp15(kuznyechik &cipher, std::pair<block128, block128> mac_key, std::pair<block128, block128> enc_key);
+
+    void wrap(std::pair<block128, block128>* keys, uint64_t* ivs, wrapped_key* out, std::size_t count);
+    std::size_t unwrap(wrapped_key* wrapped, uint64_t* ivs, std::pair<block128, block128>* out,
+                       bool* valid, std::size_t count);
+
+    kuznyechik &cipher;
+    omac mac;
+    block128 enc_keys[11];
+
+private:
+    void mac_batch(std::pair<block128, block128>* keys, uint64_t* ivs, block128* tags, std::size_t count);
+    void ctr_batch(block128* data, uint64_t* ivs, std::size_t count);
+};
@@ -1,4 +1,6 @@
 #include <array>
+#include <algorithm>
+#include <cstring>
 #include "kuznyechik.hpp"
 #include "block128.hpp"
 
@@ -9,52 +11,131 @@ block128 kuznyechik::get_iterative_const(size_t i) {
     return bl;
 }
 
-void kuznyechik::set_iterative_keys(std::pair<block128, block128> &key) {
-    iterative_keys[1] = key.first;
-    decryption_keys[1] = key.first;
-    iterative_keys[2] = key.second;
-    std::pair<block128, block128> prev = key;
-    for(std::size_t i = 1; i < 5; i++) {
-        for (std::size_t j = 1; j < 9; j++) {
-            block128 iter_const = get_iterative_const(8 * (i - 1) + j);
-            F_k(iter_const, prev);
+void kuznyechik::GenerateIterativeConsts() {
+    for (std::size_t i = 1; i <= KEY_SCHEDULE_ROUNDS; i++) {
+        iterative_consts[i] = get_iterative_const(i);
+    }
+}
+
+void kuznyechik::expand_key(std::pair<block128, block128> key, block128* keys) {
+    keys[1] = key.first;
+    keys[2] = key.second;
+    for (std::size_t i = 1; i <= KEY_SCHEDULE_ROUNDS; i++) {
+        F_k(iterative_consts[i], key);
+        if (i % 8 == 0) {
+            keys[i / 4 + 1] = key.first;
+            keys[i / 4 + 2] = key.second;
         }
-        iterative_keys[2*i+1] = prev.first;
-        iterative_keys[2*i+2] = prev.second;
     }
+}
+
+void kuznyechik::set_iterative_keys(std::pair<block128, block128> &key) {
+    expand_key(key, iterative_keys);
+    set_decryption_keys();
+}
+
+void kuznyechik::set_decryption_keys() {
+    expand_decryption_keys(iterative_keys, decryption_keys);
+}
+
+void kuznyechik::expand_decryption_keys(block128* keys, block128* dec_keys) {
+    dec_keys[1] = keys[1];
     for(size_t i = 2; i < 11; i++) {
-        decryption_keys[i] = iterative_keys[i];
-        L_inv(decryption_keys[i]);
+        dec_keys[i] = keys[i];
+        ApplyLS(dec_keys[i], dec_l_table);
     }
 }
 
 void kuznyechik::encrypt(block128 &plaintext) {
+    encrypt(plaintext, iterative_keys);
+}
+
+void kuznyechik::encrypt(block128 &plaintext, block128* keys) {
     for(std::size_t i = 1; i <= 10; i++) {
-        X_k(plaintext, iterative_keys[i]);
+        X_k(plaintext, keys[i]);
         if (i != 10) {
             ApplyLS(plaintext, enc_ls_table);
         }
     }
 }
 
+void kuznyechik::encrypt_blocks(block128* data, std::size_t count) {
+    encrypt_blocks(data, count, iterative_keys);
+}
+
+// Rounds of BATCH_BLOCKS independent blocks are interleaved so the table
+// lookups of one block overlap with the others.
+void kuznyechik::encrypt_blocks(block128* data, std::size_t count, block128* keys) {
+    std::size_t n = 0;
+    for (; n + BATCH_BLOCKS <= count; n += BATCH_BLOCKS) {
+        block128* b = data + n;
+        for (std::size_t i = 1; i < 10; i++) {
+            for (std::size_t j = 0; j < BATCH_BLOCKS; j++) {
+                X_k(b[j], keys[i]);
+                ApplyLS(b[j], enc_ls_table);
+            }
+        }
+        for (std::size_t j = 0; j < BATCH_BLOCKS; j++) {
+            X_k(b[j], keys[10]);
+        }
+    }
+    for (; n < count; n++) {
+        encrypt(data[n], keys);
+    }
+}
+
 void kuznyechik::decrypt(block128 &ciphertext) {
+    decrypt(ciphertext, iterative_keys, decryption_keys);
+}
+
+void kuznyechik::decrypt(block128 &ciphertext, block128* keys, block128* dec_keys) {
     ApplyLS(ciphertext, dec_l_table);
     for(std::size_t i = 9; i >= 1; i--) {
-        X_k(ciphertext, decryption_keys[i + 1]);
+        X_k(ciphertext, dec_keys[i + 1]);
         if (i != 1) {
             ApplyLS(ciphertext, dec_ls_table);
         }
     }
     S_inv(ciphertext);
-    X_k(ciphertext, iterative_keys[1]);
+    X_k(ciphertext, keys[1]);
+}
+
+void kuznyechik::decrypt_blocks(block128* data, std::size_t count) {
+    decrypt_blocks(data, count, iterative_keys, decryption_keys);
+}
+
+void kuznyechik::decrypt_blocks(block128* data, std::size_t count, block128* keys, block128* dec_keys) {
+    std::size_t n = 0;
+    for (; n + BATCH_BLOCKS <= count; n += BATCH_BLOCKS) {
+        block128* b = data + n;
+        for (std::size_t j = 0; j < BATCH_BLOCKS; j++) {
+            ApplyLS(b[j], dec_l_table);
+        }
+        for (std::size_t i = 9; i >= 1; i--) {
+            for (std::size_t j = 0; j < BATCH_BLOCKS; j++) {
+                X_k(b[j], dec_keys[i + 1]);
+                if (i != 1) {
+                    ApplyLS(b[j], dec_ls_table);
+                }
+            }
+        }
+        for (std::size_t j = 0; j < BATCH_BLOCKS; j++) {
+            S_inv(b[j]);
+            X_k(b[j], keys[1]);
+        }
+    }
+    for (; n < count; n++) {
+        decrypt(data[n], keys, dec_keys);
+    }
 }
 
 kuznyechik::kuznyechik(std::pair<block128, block128> key) {
-    set_iterative_keys(key);
     GenerateMulTable();
     GenerateEncTable();
     GenerateDecTable();
     GenerateDecLTable();
+    GenerateIterativeConsts();
+    set_iterative_keys(key);
 }
 
 
@@ -98,6 +179,7 @@ void kuznyechik::S_inv(block128& a) {
     }
 }
 
+#if defined(__ARM_NEON)
 static inline uint8x16_t CastBlock(const uint8_t* ptr) {
     return vld1q_u8(ptr);
 }
@@ -140,6 +222,21 @@ void kuznyechik::ApplyLS(block128& a, LookupTable& lookup_table)
     uint8x16_t final_vec = veorq_u8(vec1, vec2);
     vst1q_u8(a.a.data(), final_vec);
 }
+#else
+// Portable version of the NEON lookup: the same sum of table[i][a[i]] over
+// all positions, two 64-bit words at a time.
+void kuznyechik::ApplyLS(block128& a, LookupTable& lookup_table)
+{
+    uint64_t res[2] = {0, 0};
+    for (size_t i = 0; i < 16; i++) {
+        uint64_t row[2];
+        std::memcpy(row, lookup_table[i][a.a[i]].data(), 16);
+        res[0] ^= row[0];
+        res[1] ^= row[1];
+    }
+    std::memcpy(a.a.data(), res, 16);
+}
+#endif
 
 void kuznyechik::R(block128 &a) {
     uint8_t val = linear_transition(a);
@@ -179,8 +276,7 @@ void kuznyechik::F_k(block128 &k, std::pair<block128, block128> &a) {
     auto c = a.second;
     a.second = a.first;
     X_k(a.first, k);
-    S(a.first);
-    L(a.first);
+    ApplyLS(a.first, enc_ls_table);
     X_k(a.first, c);
 }
 
@@ -11,6 +11,10 @@ struct kuznyechik {
 
     block128 iterative_keys[11] = {block128()};
     block128 decryption_keys[11] = {block128()};
+    block128 iterative_consts[33] = {block128()};
+
+    static constexpr std::size_t KEY_SCHEDULE_ROUNDS = 32;
+    static constexpr std::size_t BATCH_BLOCKS = 4;
 
     kuznyechik::Matrix SqrMatrix(const Matrix& mat);
     static uint8_t PolyMul(uint8_t left, uint8_t right);
@@ -24,6 +28,17 @@ struct kuznyechik {
     void encrypt(block128 &plaintext);
     void decrypt(block128 &ciphertext);
 
+    void encrypt(block128 &plaintext, block128* keys);
+    void encrypt_blocks(block128* data, std::size_t count);
+    void encrypt_blocks(block128* data, std::size_t count, block128* keys);
+
+    void decrypt(block128 &ciphertext, block128* keys, block128* dec_keys);
+    void decrypt_blocks(block128* data, std::size_t count);
+    void decrypt_blocks(block128* data, std::size_t count, block128* keys, block128* dec_keys);
+
+    void expand_key(std::pair<block128, block128> key, block128* keys);
+    void expand_decryption_keys(block128* keys, block128* dec_keys);
+
 
     void ApplyLS(block128 &a, LookupTable&);
 
@@ -49,6 +64,8 @@ struct kuznyechik {
     uint8_t mul_table[256][256];
 
     void set_iterative_keys(std::pair<block128, block128> &key);
+    void set_decryption_keys();
+    void GenerateIterativeConsts();
     void GenerateEncTable();
     void GenerateMulTable();
     void GenerateDecTable();
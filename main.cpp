@@ -1,9 +1,20 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <iomanip>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <thread>
 #include "kuznyechik.hpp"
 #include "block128.hpp"
+#include "acpkm.hpp"
+#include "omac.hpp"
+#include "kexp15.hpp"
+#include "iov.hpp"
+#include "mgm.hpp"
+#include "container.hpp"
 
 block128 create_random_block() {
     std::array<uint8_t, 16> block;
@@ -236,6 +247,457 @@ bool test_decrypt() {
 }
 
 
+std::vector<block128> reference_ctr_acpkm(std::pair<block128, block128> key, uint64_t iv,
+                                          std::size_t section_blocks, std::size_t count) {
+    kuznyechik ref(key);
+    std::vector<block128> gamma;
+    for (std::size_t i = 0; i < count; i++) {
+        if (section_blocks != 0 && i > 0 && i % section_blocks == 0) {
+            block128 d1 = block128("808182838485868788898a8b8c8d8e8f");
+            block128 d2 = block128("909192939495969798999a9b9c9d9e9f");
+            ref.encrypt(d1);
+            ref.encrypt(d2);
+            ref.update_key({d1, d2});
+        }
+        block128 ctr = block128((uint64_t)i);
+        store_be64(ctr.a.data(), iv);
+        ref.encrypt(ctr);
+        gamma.push_back(ctr);
+    }
+    return gamma;
+}
+
+bool test_ctr_acpkm_vector() {
+    std::pair<block128, block128> key = {block128("8899aabbccddeeff0011223344556677"),
+                                         block128("fedcba98765432100123456789abcdef")};
+    std::pair<std::string, std::string> tcs[3] = {
+            {"1122334455667700ffeeddccbbaa9988", "f195d8bec10ed1dbd57b5fa240bda1b8"},
+            {"00112233445566778899aabbcceeff0a", "85eee733f6a13e5df33ce4b33c45dee4"},
+            {"112233445566778899aabbcceeff0a00", "4bceeb8f646f4c55001706275e85e800"}
+    };
+    kuznyechik kuzya = kuznyechik(key);
+    ctr_acpkm ctr(kuzya, key, 0x1234567890abcef0, 2);
+    for (auto &tc: tcs) {
+        auto bl = block128(tc.first);
+        ctr.apply(&bl, 1);
+        if (bl.to_string() != tc.second) {
+            std::cout << bl.to_string() << " " << tc.second << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool test_ctr_acpkm(kuznyechik& kuzya) {
+    std::pair<block128, block128> key = {create_random_block(), create_random_block()};
+    std::size_t count = 200;
+
+    for (std::size_t section_blocks : {0, 1, 2, 3, 8, 13, 64}) {
+        auto expected = reference_ctr_acpkm(key, 0x1234567890abcef0, section_blocks, count);
+        ctr_acpkm ctr(kuzya, key, 0x1234567890abcef0, section_blocks);
+        std::vector<block128> gamma(count);
+        for (std::size_t pos = 0, chunk = 1; pos < count; pos += chunk, chunk = chunk % 7 + 1) {
+            ctr.keystream(gamma.data() + pos, std::min(chunk, count - pos));
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            if (gamma[i].to_string() != expected[i].to_string()) {
+                std::cout << section_blocks << " " << i << ": " << gamma[i].to_string() << " "
+                          << expected[i].to_string() << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+block128 reference_omac_acpkm(std::pair<block128, block128> key, std::size_t section_blocks,
+                              std::size_t master_section_blocks, std::vector<uint8_t>& msg) {
+    std::size_t blocks = std::max<std::size_t>(1, (msg.size() + 15) / 16);
+    std::size_t sections = (blocks + section_blocks - 1) / section_blocks;
+    auto material = reference_ctr_acpkm(key, UINT64_MAX, master_section_blocks, 3 * sections);
+
+    kuznyechik ref(key);
+    block128 chain = block128((uint64_t)0);
+    for (std::size_t i = 0; i < blocks; i++) {
+        std::size_t s = i / section_blocks;
+        if (i % section_blocks == 0) {
+            ref.update_key({material[3 * s], material[3 * s + 1]});
+        }
+        block128 bl = block128((uint64_t)0);
+        std::size_t len = std::min<std::size_t>(16, msg.size() - i * 16);
+        if (len > 0) {
+            std::memcpy(bl.a.data(), msg.data() + i * 16, len);
+        }
+        ref.X_k(chain, bl);
+        if (i + 1 == blocks) {
+            block128 key_star = material[3 * s + 2];
+            if (len < 16) {
+                chain.a[len] ^= 0x80;
+                uint8_t carry = key_star.a[0] >> 7;
+                for (std::size_t j = 0; j < 15; j++) {
+                    key_star.a[j] = (key_star.a[j] << 1) | (key_star.a[j + 1] >> 7);
+                }
+                key_star.a[15] = (key_star.a[15] << 1) ^ (carry ? 0x87 : 0);
+            }
+            ref.X_k(chain, key_star);
+        }
+        ref.encrypt(chain);
+    }
+    return chain;
+}
+
+bool test_omac_acpkm_vector() {
+    std::pair<block128, block128> key = {block128("8899aabbccddeeff0011223344556677"),
+                                         block128("fedcba98765432100123456789abcdef")};
+    // N = 256 bits (2 blocks), T* = 768 bits (6 blocks)
+    std::string material[3] = {
+            "0cabf1f2efbc4ac16048df1a24c605b2",
+            "c0d1673d7586a8ec0dd42c45a4f95bae",
+            "0f2e2617e47148680fc3e6178df2c137"
+    };
+    std::string msg = "1122334455667700ffeeddccbbaa9988"
+                      "00112233445566778899aabbcceeff0a"
+                      "112233445566778899aabbcceeff0a00"
+                      "2233445566778899aabbcceeff0a0011"
+                      "33445566778899aabbcceeff0a001122";
+    std::vector<uint8_t> bytes;
+    for (std::size_t i = 0; i < msg.size(); i += 2) {
+        bytes.push_back(static_cast<uint8_t>(std::stoi(msg.substr(i, 2), nullptr, 16)));
+    }
+    kuznyechik kuzya = kuznyechik(key);
+
+    omac_acpkm mac(kuzya, key, 2, 6);
+    if (mac.keys[1].to_string() != material[0] || mac.keys[2].to_string() != material[1] ||
+        mac.k1.to_string() != material[2]) {
+        return false;
+    }
+    // one and a half blocks: a single section, padded last block
+    mac.update(bytes.data(), 24);
+    if (mac.finalize().to_string() != "b5367f47b62b995eeb2a648c5843145e") {
+        return false;
+    }
+    // five blocks: three sections, the master key meshes after six blocks
+    omac_acpkm long_mac(kuzya, key, 2, 6);
+    long_mac.update(bytes.data(), bytes.size());
+    return long_mac.finalize().to_string() == "fbb8dcee45bea67c35f58c5700898e5d";
+}
+
+bool test_omac_acpkm(kuznyechik& kuzya) {
+    std::pair<block128, block128> key = {create_random_block(), create_random_block()};
+
+    for (std::size_t len : {0, 1, 16, 17, 32, 47, 64, 65, 200, 1000}) {
+        std::vector<uint8_t> msg(len);
+        for (auto &b: msg) {
+            b = rand() % 256;
+        }
+        for (std::size_t section_blocks : {0, 2}) {
+            // a single section as long as the message is what section_blocks = 0 means
+            std::size_t reference_section = section_blocks != 0 ? section_blocks :
+                                            std::max<std::size_t>(1, (len + 15) / 16);
+            auto expected = reference_omac_acpkm(key, reference_section, 3, msg);
+            omac_acpkm mac(kuzya, key, section_blocks, 3);
+            for (std::size_t pos = 0, chunk = 1; pos < len; pos += chunk, chunk = chunk * 3 % 37 + 1) {
+                mac.update(msg.data() + pos, std::min(chunk, len - pos));
+            }
+            auto got = mac.finalize();
+            if (got.to_string() != expected.to_string()) {
+                std::cout << len << ": " << got.to_string() << " " << expected.to_string() << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+bool test_omac_vector() {
+    std::pair<block128, block128> key = {block128("8899aabbccddeeff0011223344556677"),
+                                         block128("fedcba98765432100123456789abcdef")};
+    std::string in[4] = {
+            "1122334455667700ffeeddccbbaa9988",
+            "00112233445566778899aabbcceeff0a",
+            "112233445566778899aabbcceeff0a00",
+            "2233445566778899aabbcceeff0a0011"
+    };
+    kuznyechik kuzya = kuznyechik(key);
+    omac mac(kuzya, key);
+    if (mac.k1.to_string() != "297d82bc4d39e3ca0de0573298151dc7" ||
+        mac.k2.to_string() != "52fb05789a73c7941bc0ae65302a3b8e") {
+        return false;
+    }
+    for (auto &s: in) {
+        auto bl = block128(s);
+        mac.update(bl.a.data(), 16);
+    }
+    auto tag = mac.finalize().to_string();
+    if (tag.substr(0, 16) != "336f4d296059fbe3") {
+        std::cout << tag << " 336f4d296059fbe3\n";
+        return false;
+    }
+    return true;
+}
+
+bool test_kexp15(kuznyechik& kuzya) {
+    std::pair<block128, block128> mac_key = {create_random_block(), create_random_block()};
+    std::pair<block128, block128> enc_key = {create_random_block(), create_random_block()};
+    kexp15 kek(kuzya, mac_key, enc_key);
+    kuznyechik ref_enc(enc_key);
+    omac ref_mac(kuzya, mac_key);
+
+    std::size_t count = 11;
+    std::vector<std::pair<block128, block128>> keys;
+    std::vector<uint64_t> ivs;
+    for (std::size_t i = 0; i < count; i++) {
+        keys.emplace_back(create_random_block(), create_random_block());
+        ivs.push_back(((uint64_t)rand() << 32) ^ rand());
+    }
+    std::vector<kexp15::wrapped_key> wrapped(count);
+    kek.wrap(keys.data(), ivs.data(), wrapped.data(), count);
+
+    for (std::size_t j = 0; j < count; j++) {
+        uint8_t iv[8];
+        store_be64(iv, ivs[j]);
+        ref_mac.update(iv, 8);
+        ref_mac.update(keys[j].first.a.data(), 16);
+        ref_mac.update(keys[j].second.a.data(), 16);
+        block128 expected[3] = {keys[j].first, keys[j].second, ref_mac.finalize()};
+        for (std::size_t b = 0; b < 3; b++) {
+            block128 ctr = block128((uint64_t)b);
+            std::memcpy(ctr.a.data(), iv, 8);
+            ref_enc.encrypt(ctr);
+            ref_enc.X_k(expected[b], ctr);
+            if (wrapped[j][b].to_string() != expected[b].to_string()) {
+                std::cout << j << " " << b << ": " << wrapped[j][b].to_string() << " "
+                          << expected[b].to_string() << std::endl;
+                return false;
+            }
+        }
+    }
+
+    wrapped[5][1].a[3] ^= 1;
+    std::vector<std::pair<block128, block128>> unwrapped(count);
+    bool valid[11];
+    if (kek.unwrap(wrapped.data(), ivs.data(), unwrapped.data(), valid, count) != count - 1 || valid[5]) {
+        return false;
+    }
+    for (std::size_t j = 0; j < count; j++) {
+        if (j != 5 && (unwrapped[j].first.to_string() != keys[j].first.to_string() ||
+                       unwrapped[j].second.to_string() != keys[j].second.to_string())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<iovec> random_segments(std::vector<uint8_t>& buf, std::size_t from, std::size_t to) {
+    std::vector<iovec> iov;
+    while (from < to) {
+        std::size_t len = std::min<std::size_t>(rand() % 40, to - from);
+        iov.push_back({buf.data() + from, len});
+        from += len;
+    }
+    return iov;
+}
+
+bool test_iov_ctr(kuznyechik& kuzya) {
+    std::pair<block128, block128> key = {create_random_block(), create_random_block()};
+    std::size_t len = 1000;
+    std::vector<uint8_t> in(len), out(len);
+    for (auto &b: in) {
+        b = rand() % 256;
+    }
+
+    ctr_acpkm ref(kuzya, key, 0x1234567890abcef0, 5);
+    std::vector<block128> gamma((len + 15) / 16);
+    ref.keystream(gamma.data(), gamma.size());
+
+    ctr_acpkm ctr(kuzya, key, 0x1234567890abcef0, 5);
+    iov_ctr stream(ctr);
+    std::size_t split = 333;
+    auto in1 = random_segments(in, 0, split), out1 = random_segments(out, 0, split);
+    auto in2 = random_segments(in, split, len), out2 = random_segments(out, split, len);
+    if (!stream.apply(in1.data(), in1.size(), out1.data(), out1.size()) ||
+        !stream.apply(in2.data(), in2.size(), out2.data(), out2.size())) {
+        return false;
+    }
+    for (std::size_t i = 0; i < len; i++) {
+        if (out[i] != (in[i] ^ gamma[i / 16].a[i % 16])) {
+            std::cout << "byte " << i << " differs\n";
+            return false;
+        }
+    }
+    return !stream.apply(in1.data(), in1.size(), out2.data(), out2.size());
+}
+
+bool test_iov_cbc(kuznyechik& kuzya) {
+    std::pair<block128, block128> key = {create_random_block(), create_random_block()};
+    block128 iv = create_random_block();
+    std::size_t blocks = 37;
+    std::vector<uint8_t> in(blocks * 16), out(blocks * 16), back(blocks * 16);
+    for (auto &b: in) {
+        b = rand() % 256;
+    }
+
+    kuznyechik ref(key);
+    block128 chain = iv;
+    for (std::size_t i = 0; i < blocks; i++) {
+        block128 bl;
+        std::memcpy(bl.a.data(), in.data() + i * 16, 16);
+        ref.X_k(chain, bl);
+        ref.encrypt(chain);
+    }
+
+    iov_cbc enc(kuzya, key, iv);
+    auto in_iov = random_segments(in, 0, in.size()), out_iov = random_segments(out, 0, out.size());
+    if (!enc.encrypt(in_iov.data(), in_iov.size(), out_iov.data(), out_iov.size()) ||
+        enc.chain.to_string() != chain.to_string()) {
+        return false;
+    }
+
+    iov_cbc dec(kuzya, key, iv);
+    auto cipher_iov = random_segments(out, 0, 160), back_iov = random_segments(back, 0, 160);
+    auto cipher_iov2 = random_segments(out, 160, out.size()), back_iov2 = random_segments(back, 160, back.size());
+    if (!dec.decrypt(cipher_iov.data(), cipher_iov.size(), back_iov.data(), back_iov.size()) ||
+        !dec.decrypt(cipher_iov2.data(), cipher_iov2.size(), back_iov2.data(), back_iov2.size())) {
+        return false;
+    }
+    return back == in;
+}
+
+bool test_iov_omac(kuznyechik& kuzya) {
+    std::pair<block128, block128> key = {create_random_block(), create_random_block()};
+    std::vector<uint8_t> in(517);
+    for (auto &b: in) {
+        b = rand() % 256;
+    }
+    omac mac(kuzya, key);
+    mac.update(in.data(), in.size());
+    auto expected = mac.finalize();
+
+    auto iov = random_segments(in, 0, in.size());
+    omac_update(mac, iov.data(), iov.size());
+    return mac.finalize().to_string() == expected.to_string();
+}
+
+std::vector<uint8_t> from_hex(std::string s) {
+    std::vector<uint8_t> res;
+    for (std::size_t i = 0; i < s.size(); i += 2) {
+        res.push_back(static_cast<uint8_t>(std::stoi(s.substr(i, 2), nullptr, 16)));
+    }
+    return res;
+}
+
+bool test_mgm_vector() {
+    std::pair<block128, block128> key = {block128("8899aabbccddeeff0011223344556677"),
+                                         block128("fedcba98765432100123456789abcdef")};
+    auto aad = from_hex("0202020202020202010101010101010104040404040404040303030303030303ea0505050505050505");
+    auto plain = from_hex("1122334455667700ffeeddccbbaa998800112233445566778899aabbcceeff0a"
+                          "112233445566778899aabbcceeff0a002233445566778899aabbcceeff0a0011aabbcc");
+    auto expected = from_hex("a9757b8147956e9055b8a33de89f42fc8075d2212bf9fd5bd3f7069aadc16b39"
+                             "497ab15915a6ba85936b5d0ea9f6851cc60c14d4d3f883d0ab94420695c76deb2c7552");
+
+    kuznyechik kuzya = kuznyechik(key);
+    mgm aead(kuzya, key);
+    std::vector<uint8_t> out(plain.size()), back(plain.size());
+    aead.start(block128("1122334455667700ffeeddccbbaa9988"));
+    aead.update_aad(aad.data(), 7);
+    aead.update_aad(aad.data() + 7, aad.size() - 7);
+    aead.encrypt(plain.data(), out.data(), 19);
+    aead.encrypt(plain.data() + 19, out.data() + 19, plain.size() - 19);
+    if (out != expected || aead.finalize().to_string() != "cf5d656f40c34f5c46e8bb0e29fcdb4c") {
+        return false;
+    }
+
+    aead.start(block128("1122334455667700ffeeddccbbaa9988"));
+    aead.update_aad(aad.data(), aad.size());
+    aead.decrypt(out.data(), back.data(), out.size());
+    return back == plain && aead.finalize().to_string() == "cf5d656f40c34f5c46e8bb0e29fcdb4c";
+}
+
+std::string make_container(kuznyechik& kuzya, std::pair<block128, block128> key,
+                           container_params::chunk_mode mode, std::vector<uint8_t>& data,
+                           block128 nonce = create_random_block()) {
+    std::stringstream ss;
+    container_writer writer(ss, kuzya, key, mode, 64, nonce, 3);
+    for (std::size_t pos = 0, chunk = 1; pos < data.size(); pos += chunk, chunk = chunk * 7 % 1001 + 1) {
+        chunk = std::min(chunk, data.size() - pos);
+        writer.write(data.data() + pos, chunk);
+        // a write buffers at most one batch of 3 chunks, whatever its size
+        if (writer.pending.capacity() > 3 * 64 + 1) {
+            return "";
+        }
+    }
+    // the final chunk is sealed once, nothing may follow it
+    if (!writer.finish() || writer.finish() || writer.write(data.data(), data.size())) {
+        return "";
+    }
+    return ss.str();
+}
+
+bool test_container(kuznyechik& kuzya) {
+    std::pair<block128, block128> key = {create_random_block(), create_random_block()};
+
+    for (auto mode : {container_params::CTR_OMAC, container_params::MGM}) {
+        for (std::size_t len : {0, 64, 200, 1000, 5000}) {
+            std::vector<uint8_t> data(len), got(len);
+            for (auto &b: data) {
+                b = rand() % 256;
+            }
+            std::stringstream ss(make_container(kuzya, key, mode, data));
+            container_reader reader(ss, kuzya, key, 3);
+            if (!reader.valid() || reader.size() != len || !reader.read(0, len, got.data()) || got != data) {
+                std::cout << "container of " << len << " bytes does not match\n";
+                return false;
+            }
+            for (std::size_t i = 0; i < 20 && len > 0; i++) {
+                std::size_t offset = rand() % len;
+                std::size_t n = rand() % (len - offset + 1);
+                if (!reader.read(offset, n, got.data()) ||
+                    !std::equal(got.begin(), got.begin() + n, data.begin() + offset)) {
+                    std::cout << "read of " << n << " bytes at " << offset << " does not match\n";
+                    return false;
+                }
+            }
+        }
+
+        std::vector<uint8_t> data(1000), got(1000);
+        std::string stored = make_container(kuzya, key, mode, data);
+
+        std::string tampered = stored;
+        tampered[container_params::HEADER_SIZE + 90] ^= 1;
+        std::stringstream tampered_ss(tampered);
+        container_reader tampered_reader(tampered_ss, kuzya, key, 3);
+        if (tampered_reader.read(70, 10, got.data()) || !tampered_reader.read(0, 64, got.data())) {
+            return false;
+        }
+
+        std::stringstream truncated_ss(stored.substr(0, stored.size() - (1000 % 64 + 16)));
+        container_reader truncated_reader(truncated_ss, kuzya, key, 3);
+        if (!truncated_reader.valid() || truncated_reader.read(900, 10, got.data())) {
+            return false;
+        }
+
+        // nonces one apart in either half must not share a ciphertext chunk
+        std::vector<std::string> seen;
+        block128 nonce = create_random_block();
+        nonce.a[7] &= 0xfe;
+        nonce.a[15] &= 0xfe;
+        for (std::size_t i = 0; i < 3; i++) {
+            block128 n = nonce;
+            n.a[i == 1 ? 7 : 15] += i > 0;
+            std::string body = make_container(kuzya, key, mode, data, n).substr(container_params::HEADER_SIZE);
+            for (std::size_t pos = 0; pos < 2 * (64 + 16); pos += 64 + 16) {
+                seen.push_back(body.substr(pos, 64));
+            }
+        }
+        std::sort(seen.begin(), seen.end());
+        if (std::adjacent_find(seen.begin(), seen.end()) != seen.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void check_test_res(std::string name, bool res) {
     if (!res) {
         std::cerr << name << ": FAILED!" << std::endl;
@@ -260,8 +722,116 @@ void correctness_test() {
     check_test_res("Test setting keys", test_set_keys());
     check_test_res("Test cypher a block", test_cyphertext());
     check_test_res("Test decrypt a block", test_decrypt());
+    check_test_res("Test CTR-ACPKM vector", test_ctr_acpkm_vector());
+    check_test_res("Test CTR-ACPKM", test_ctr_acpkm(kuzya));
+    check_test_res("Test OMAC-ACPKM vector", test_omac_acpkm_vector());
+    check_test_res("Test OMAC-ACPKM", test_omac_acpkm(kuzya));
+    check_test_res("Test OMAC vector", test_omac_vector());
+    check_test_res("Test KExp15/KImp15", test_kexp15(kuzya));
+    check_test_res("Test iovec CTR", test_iov_ctr(kuzya));
+    check_test_res("Test iovec CBC", test_iov_cbc(kuzya));
+    check_test_res("Test iovec OMAC", test_iov_omac(kuzya));
+    check_test_res("Test MGM vector", test_mgm_vector());
+    check_test_res("Test container", test_container(kuzya));
+}
+
+
+void print_speed(std::string name, long long elapsed_total) {
+    double seconds_total = (elapsed_total * 1.0) / 1000;
+    double seconds_100Mb = seconds_total / 10;
+    int speed = ceil(100 / seconds_100Mb);
+
+    std::cout << name << "\n";
+    std::cout << "1Gb of data was processed in " << seconds_total << " seconds" << std::endl;
+    std::cout << "Average time of processing 100Mb of data is " << seconds_100Mb << " seconds" << std::endl;
+    std::cout << "Total speed of algorithm is " << speed << " Mb/sec\n";
+}
+
+long long measure_ctr_acpkm(kuznyechik& kuzya, std::vector<block128>& data, std::size_t section_blocks) {
+    std::pair<block128, block128> key = {create_random_block(), create_random_block()};
+    ctr_acpkm ctr(kuzya, key, 0x1234567890abcef0, section_blocks);
+
+    long long elapsed_total = 0;
+    for (std::size_t iter = 0; iter < 10; iter++) {
+        auto start = std::chrono::system_clock::now();
+        ctr.apply(data.data(), data.size());
+        auto end = std::chrono::system_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        std::cout << iter << " : " << elapsed.count() / 1000.0 << " sec\n";
+        elapsed_total += elapsed.count();
+    }
+    return elapsed_total;
+}
+
+void kexp15_performance_test(kuznyechik& kuzya) {
+    std::size_t KEYS = 1000000;
+
+    kexp15 kek(kuzya, {create_random_block(), create_random_block()},
+               {create_random_block(), create_random_block()});
+    std::vector<std::pair<block128, block128>> keys;
+    std::vector<uint64_t> ivs;
+    for (std::size_t i = 0; i < KEYS; i++) {
+        keys.emplace_back(create_random_block(), create_random_block());
+        ivs.push_back(i);
+    }
+    std::vector<kexp15::wrapped_key> wrapped(KEYS);
+    std::unique_ptr<bool[]> valid(new bool[KEYS]);
+
+    auto start = std::chrono::system_clock::now();
+    kek.wrap(keys.data(), ivs.data(), wrapped.data(), KEYS);
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::cout << "KEXP15\n";
+    std::cout << KEYS << " keys were wrapped in " << elapsed.count() / 1000.0 << " seconds" << std::endl;
+    std::cout << "Total speed is " << (long long)(KEYS * 1000.0 / elapsed.count()) << " wraps/sec\n";
+
+    start = std::chrono::system_clock::now();
+    kek.unwrap(wrapped.data(), ivs.data(), keys.data(), valid.get(), KEYS);
+    end = std::chrono::system_clock::now();
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::cout << "KIMP15\n";
+    std::cout << KEYS << " keys were unwrapped in " << elapsed.count() / 1000.0 << " seconds" << std::endl;
+    std::cout << "Total speed is " << (long long)(KEYS * 1000.0 / elapsed.count()) << " unwraps/sec\n";
 }
 
+void container_performance_test(kuznyechik& kuzya, std::vector<block128>& data,
+                                container_params::chunk_mode mode, std::string name) {
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t RANDOM_READS = 10000;
+    std::size_t READ_SIZE = 4096;
+    std::pair<block128, block128> key = {create_random_block(), create_random_block()};
+    const uint8_t* bytes = data[0].a.data();
+    std::size_t len = data.size() * sizeof(block128);
+
+    std::stringstream ss;
+    auto start = std::chrono::system_clock::now();
+    container_writer writer(ss, kuzya, key, mode, 65536, create_random_block(), threads);
+    writer.write(bytes, len);
+    writer.finish();
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::cout << name << ", 64Kb chunks, " << threads << " threads\n";
+    std::cout << "Sequential write speed is " << (long long)(len / 1000.0 / elapsed.count()) << " Mb/sec\n";
+
+    container_reader reader(ss, kuzya, key, threads);
+    std::vector<uint8_t> out(8 << 20);
+    start = std::chrono::system_clock::now();
+    for (uint64_t offset = 0; offset < reader.size(); offset += out.size()) {
+        reader.read(offset, std::min<uint64_t>(out.size(), reader.size() - offset), out.data());
+    }
+    end = std::chrono::system_clock::now();
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::cout << "Sequential read speed is " << (long long)(len / 1000.0 / elapsed.count()) << " Mb/sec\n";
+
+    start = std::chrono::system_clock::now();
+    for (std::size_t i = 0; i < RANDOM_READS; i++) {
+        reader.read(rand() % (reader.size() - READ_SIZE), READ_SIZE, out.data());
+    }
+    end = std::chrono::system_clock::now();
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::cout << "Random " << READ_SIZE << " byte reads: "
+              << (long long)(RANDOM_READS * 1000.0 / elapsed.count()) << " reads/sec\n";
+}
 
 void performance_test() {
     std::size_t BLOCKS_IN_100Mb = 6250000;
@@ -319,6 +889,15 @@ void performance_test() {
     std::cout << "1Gb of data was processed in " << seconds_total << " seconds" << std::endl;
     std::cout << "Average time of processing 100Mb of data is " << seconds_100Mb << " seconds" << std::endl;
     std::cout << "Total speed of algorithm is " << speed << " Mb/sec\n";
+
+    print_speed("CTR (no key meshing)", measure_ctr_acpkm(kuzya, data, 0));
+    print_speed("CTR-ACPKM, 4Kb sections", measure_ctr_acpkm(kuzya, data, 256));
+    print_speed("CTR-ACPKM, 256 byte sections", measure_ctr_acpkm(kuzya, data, 16));
+
+    kexp15_performance_test(kuzya);
+
+    container_performance_test(kuzya, data, container_params::CTR_OMAC, "CONTAINER, CTR + OMAC");
+    container_performance_test(kuzya, data, container_params::MGM, "CONTAINER, MGM");
 }
 
 int main() {
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cstring>
+#include "mgm.hpp"
+
+static constexpr std::size_t MGM_BATCH_BLOCKS = 2 * kuznyechik::BATCH_BLOCKS;
+
+static void increment_half(block128 &a, std::size_t low) {
+    for (std::size_t i = low + 7; i + 1 > low; i--) {
+        if (++a.a[i] != 0) {
+            break;
+        }
+    }
+}
+
+#if defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO) || defined(__PCLMUL__)
+#if defined(__PCLMUL__)
+#include <wmmintrin.h>
+
+static void clmul64(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo) {
+    __m128i r = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long) a), _mm_set_epi64x(0, (long long) b), 0);
+    lo = (uint64_t) _mm_cvtsi128_si64(r);
+    hi = (uint64_t) _mm_cvtsi128_si64(_mm_unpackhi_epi64(r, r));
+}
+#else
+static void clmul64(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo) {
+    uint64x2_t r = vreinterpretq_u64_p128(vmull_p64(a, b));
+    lo = vgetq_lane_u64(r, 0);
+    hi = vgetq_lane_u64(r, 1);
+}
+#endif
+
+// Multiplication in GF(2^128) modulo x^128 + x^7 + x^2 + x + 1, the first
+// byte of a block holds the highest coefficients. Four carry-less 64-bit
+// products give the 256-bit one, whose upper half is folded back with two
+// more multiplications by x^7 + x^2 + x + 1.
+block128 mgm::gf_mul(block128 &a, block128 &b) {
+    uint64_t x_hi = load_be64(a.a.data()), x_lo = load_be64(a.a.data() + 8);
+    uint64_t y_hi = load_be64(b.a.data()), y_lo = load_be64(b.a.data() + 8);
+    uint64_t r[4], m1_hi, m1_lo, m2_hi, m2_lo;
+    clmul64(x_lo, y_lo, r[1], r[0]);
+    clmul64(x_hi, y_hi, r[3], r[2]);
+    clmul64(x_hi, y_lo, m1_hi, m1_lo);
+    clmul64(x_lo, y_hi, m2_hi, m2_lo);
+    r[1] ^= m1_lo ^ m2_lo;
+    r[2] ^= m1_hi ^ m2_hi;
+
+    uint64_t f_hi, f_lo;
+    clmul64(r[3], 0x87, f_hi, f_lo);
+    r[1] ^= f_lo;
+    r[2] ^= f_hi;
+    clmul64(r[2], 0x87, f_hi, f_lo);
+    r[0] ^= f_lo;
+    r[1] ^= f_hi;
+
+    block128 res;
+    store_be64(res.a.data(), r[1]);
+    store_be64(res.a.data() + 8, r[0]);
+    return res;
+}
+#else
+// x^128 * t(x) reduced for every 4-bit t, i.e. t(x) * (x^7 + x^2 + x + 1)
+static constexpr uint64_t GF_REDUCE[16] = {
+        0x0000, 0x0087, 0x010e, 0x0189, 0x021c, 0x029b, 0x0312, 0x0395,
+        0x0438, 0x04bf, 0x0536, 0x05b1, 0x0624, 0x06a3, 0x072a, 0x07ad
+};
+
+// Multiplication in GF(2^128) modulo x^128 + x^7 + x^2 + x + 1, the first
+// byte of a block holds the highest coefficients. b is multiplied by all 16
+// polynomials of degree < 4 first, then a is consumed a nibble at a time
+// from the top, Horner style.
+block128 mgm::gf_mul(block128 &a, block128 &b) {
+    uint64_t t_hi[16], t_lo[16];
+    t_hi[0] = t_lo[0] = 0;
+    t_hi[1] = load_be64(b.a.data());
+    t_lo[1] = load_be64(b.a.data() + 8);
+    for (std::size_t i = 2; i < 16; i += 2) {
+        uint64_t carry = 0 - (t_hi[i / 2] >> 63);
+        t_hi[i] = (t_hi[i / 2] << 1) | (t_lo[i / 2] >> 63);
+        t_lo[i] = (t_lo[i / 2] << 1) ^ (carry & 0x87);
+        t_hi[i + 1] = t_hi[i] ^ t_hi[1];
+        t_lo[i + 1] = t_lo[i] ^ t_lo[1];
+    }
+
+    uint64_t r_hi = 0, r_lo = 0;
+    for (std::size_t i = 0; i < 32; i++) {
+        uint8_t n = i % 2 == 0 ? a.a[i / 2] >> 4 : a.a[i / 2] & 15;
+        uint64_t top = r_hi >> 60;
+        r_hi = (r_hi << 4) | (r_lo >> 60);
+        r_lo = (r_lo << 4) ^ GF_REDUCE[top];
+        r_hi ^= t_hi[n];
+        r_lo ^= t_lo[n];
+    }
+    block128 res;
+    store_be64(res.a.data(), r_hi);
+    store_be64(res.a.data() + 8, r_lo);
+    return res;
+}
+#endif
+
+mgm::mgm(kuznyechik &cipher, std::pair<block128, block128> key)
+        : cipher(cipher), y(uint64_t{0}), z(uint64_t{0}), sum(uint64_t{0}), buffer(uint64_t{0}), gamma(uint64_t{0}) {
+    cipher.expand_key(key, keys);
+}
+
+void mgm::start(block128 nonce) {
+    y = nonce;
+    y.a[0] &= 0x7f;
+    z = nonce;
+    z.a[0] |= 0x80;
+    cipher.encrypt(y, keys);
+    cipher.encrypt(z, keys);
+    sum.a.fill(0);
+    buffered = 0;
+    gamma_used = 16;
+    text_started = false;
+    aad_len = 0;
+    text_len = 0;
+}
+
+void mgm::absorb(block128 &block) {
+    block128 h = z;
+    cipher.encrypt(h, keys);
+    increment_half(z, 0);
+    block128 prod = gf_mul(h, block);
+    cipher.X_k(sum, prod);
+}
+
+void mgm::update_aad(const uint8_t* data, std::size_t len) {
+    aad_len += len;
+    while (len > 0) {
+        std::size_t n = std::min(len, 16 - buffered);
+        std::memcpy(buffer.a.data() + buffered, data, n);
+        buffered += n;
+        data += n;
+        len -= n;
+        if (buffered == 16) {
+            absorb(buffer);
+            buffered = 0;
+        }
+    }
+}
+
+void mgm::finish_aad() {
+    if (buffered > 0) {
+        std::fill(buffer.a.begin() + buffered, buffer.a.end(), 0);
+        absorb(buffer);
+        buffered = 0;
+    }
+    text_started = true;
+}
+
+void mgm::encrypt(const uint8_t* in, uint8_t* out, std::size_t len) {
+    crypt(in, out, len, true);
+}
+
+void mgm::decrypt(const uint8_t* in, uint8_t* out, std::size_t len) {
+    crypt(in, out, len, false);
+}
+
+void mgm::crypt(const uint8_t* in, uint8_t* out, std::size_t len, bool encrypting) {
+    if (!text_started) {
+        finish_aad();
+    }
+    text_len += len;
+
+    // y and z blocks of a batch share one encrypt_blocks call
+    block128 batch[2 * MGM_BATCH_BLOCKS];
+    while (len > 0) {
+        if (gamma_used < 16) {
+            std::size_t n = std::min(len, 16 - gamma_used);
+            for (std::size_t i = 0; i < n; i++) {
+                uint8_t c = encrypting ? in[i] ^ gamma.a[gamma_used + i] : in[i];
+                out[i] = in[i] ^ gamma.a[gamma_used + i];
+                buffer.a[gamma_used + i] = c;
+            }
+            gamma_used += n;
+            in += n;
+            out += n;
+            len -= n;
+            if (gamma_used == 16) {
+                absorb(buffer);
+            }
+        } else if (len >= 16) {
+            std::size_t blocks = std::min(len / 16, MGM_BATCH_BLOCKS);
+            for (std::size_t i = 0; i < blocks; i++) {
+                batch[i] = y;
+                increment_half(y, 8);
+                batch[blocks + i] = z;
+                increment_half(z, 0);
+            }
+            cipher.encrypt_blocks(batch, 2 * blocks, keys);
+            for (std::size_t i = 0; i < blocks; i++) {
+                block128 c;
+                std::memcpy(c.a.data(), in + 16 * i, 16);
+                for (std::size_t j = 0; j < 16; j++) {
+                    out[16 * i + j] = in[16 * i + j] ^ batch[i].a[j];
+                }
+                if (encrypting) {
+                    std::memcpy(c.a.data(), out + 16 * i, 16);
+                }
+                block128 prod = gf_mul(batch[blocks + i], c);
+                cipher.X_k(sum, prod);
+            }
+            in += 16 * blocks;
+            out += 16 * blocks;
+            len -= 16 * blocks;
+        } else {
+            gamma = y;
+            increment_half(y, 8);
+            cipher.encrypt(gamma, keys);
+            gamma_used = 0;
+        }
+    }
+}
+
+block128 mgm::finalize() {
+    if (!text_started) {
+        finish_aad();
+    }
+    if (gamma_used < 16) {
+        std::fill(buffer.a.begin() + gamma_used, buffer.a.end(), 0);
+        absorb(buffer);
+        gamma_used = 16;
+    }
+    block128 lengths;
+    store_be64(lengths.a.data(), aad_len * 8);
+    store_be64(lengths.a.data() + 8, text_len * 8);
+    absorb(lengths);
+
+    block128 tag = sum;
+    cipher.encrypt(tag, keys);
+    return tag;
+}
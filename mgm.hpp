@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include "kuznyechik.hpp"
+#include "block128.hpp"
+
+// MGM (Multilinear Galois Mode) AEAD from R 1323565.1.026. The top bit of the
+// nonce is ignored, E_K(0 || ICN) starts the encryption counter and
+// E_K(1 || ICN) the authentication one. Counter and H blocks of a batch are
+// encrypted together through encrypt_blocks. Additional data has to be
+// supplied before the text.
+struct mgm {
+    mgm(kuznyechik &cipher, std::pair<block128, block128> key);
+
+    void start(block128 nonce);
+    void update_aad(const uint8_t* data, std::size_t len);
+    void encrypt(const uint8_t* in, uint8_t* out, std::size_t len);
+    void decrypt(const uint8_t* in, uint8_t* out, std::size_t len);
+    block128 finalize();
+
+    static block128 gf_mul(block128 &a, block128 &b);
+
+    kuznyechik &cipher;
+    block128 keys[11];
+    block128 y;
+    block128 z;
+    block128 sum;
+    block128 buffer;
+    block128 gamma;
+    std::size_t buffered = 0;
+    std::size_t gamma_used = 16;
+    bool text_started = false;
+    uint64_t aad_len = 0;
+    uint64_t text_len = 0;
+
+private:
+    void crypt(const uint8_t* in, uint8_t* out, std::size_t len, bool encrypting);
+    void absorb(block128 &block);
+    void finish_aad();
+};
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <cstring>
+#include "omac.hpp"
+
+omac::omac(kuznyechik &cipher, std::pair<block128, block128> key)
+        : cipher(cipher), k1(uint64_t{0}), chain(uint64_t{0}), buffer(uint64_t{0}) {
+    cipher.expand_key(key, keys);
+    cipher.encrypt(k1, keys);
+    double_block(k1);
+    k2 = k1;
+    double_block(k2);
+}
+
+// Multiplication by x in GF(2^128) with B_128 = 0^120 || 10000111.
+void omac::double_block(block128 &a) {
+    uint8_t carry = a.a[0] >> 7;
+    for (size_t i = 0; i < 15; i++) {
+        a.a[i] = static_cast<uint8_t>((a.a[i] << 1) | (a.a[i + 1] >> 7));
+    }
+    a.a[15] = static_cast<uint8_t>(a.a[15] << 1);
+    if (carry) {
+        a.a[15] ^= 0x87;
+    }
+}
+
+void omac::update(const uint8_t* data, std::size_t len) {
+    while (len > 0) {
+        // the last block is held back until finalize, it is masked with K1 or K2
+        if (buffered == 16) {
+            cipher.X_k(chain, buffer);
+            cipher.encrypt(chain, keys);
+            buffered = 0;
+        }
+        std::size_t n = std::min(len, 16 - buffered);
+        std::memcpy(buffer.a.data() + buffered, data, n);
+        buffered += n;
+        data += n;
+        len -= n;
+    }
+}
+
+block128 omac::finalize() {
+    if (buffered < 16) {
+        std::fill(buffer.a.begin() + buffered, buffer.a.end(), 0);
+        buffer.a[buffered] = 0x80;
+        cipher.X_k(chain, k2);
+    } else {
+        cipher.X_k(chain, k1);
+    }
+    cipher.X_k(chain, buffer);
+    cipher.encrypt(chain, keys);
+    block128 tag = chain;
+    reset();
+    return tag;
+}
+
+void omac::reset() {
+    chain.a.fill(0);
+    buffered = 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include "kuznyechik.hpp"
+#include "block128.hpp"
+
+// OMAC (CMAC) from GOST R 34.13-2015 with a full n = 128 bit tag, truncate
+// the result for shorter MACs. Like the ACPKM modes it keeps its own round
+// keys and only uses the lookup tables of cipher.
+struct omac {
+    omac(kuznyechik &cipher, std::pair<block128, block128> key);
+
+    void update(const uint8_t* data, std::size_t len);
+    block128 finalize();
+    void reset();
+
+    static void double_block(block128 &a);
+
+    kuznyechik &cipher;
+    block128 keys[11];
+    block128 k1;
+    block128 k2;
+    block128 chain;
+    block128 buffer;
+    std::size_t buffered = 0;
+};
@@ -0,0 +1,858 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <openssl/core.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/evp.h>
+
+#include "kuznyechik.hpp"
+#include "block128.hpp"
+#include "acpkm.hpp"
+#include "omac.hpp"
+#include "iov.hpp"
+#include "mgm.hpp"
+
+// OpenSSL 3 provider module. One kuznyechik context per provider holds the
+// lookup tables, every cipher and MAC context keeps its own round keys in a
+// mode object built on top of it.
+
+#define KUZNYECHIK_PARAM_KEY_MESH "key-mesh"
+
+enum cipher_mode { MODE_ECB, MODE_CBC, MODE_CTR, MODE_CTR_ACPKM, MODE_MGM };
+
+static constexpr std::size_t KEY_LEN = 32;
+static constexpr std::size_t DEFAULT_SECTION_BYTES = 4096;
+
+struct provider_ctx {
+    const OSSL_CORE_HANDLE* handle;
+    kuznyechik cipher = kuznyechik({block128(uint64_t{0}), block128(uint64_t{0})});
+};
+
+static void cleanse(iov_cbc &m) {
+    OPENSSL_cleanse(m.keys, sizeof(m.keys));
+    OPENSSL_cleanse(m.dec_keys, sizeof(m.dec_keys));
+    OPENSSL_cleanse(&m.chain, sizeof(m.chain));
+}
+
+static void cleanse(ctr_acpkm &m) {
+    OPENSSL_cleanse(m.keys, sizeof(m.keys));
+    OPENSSL_cleanse(&m.counter, sizeof(m.counter));
+}
+
+static void cleanse(iov_ctr &m) {
+    OPENSSL_cleanse(&m.gamma, sizeof(m.gamma));
+}
+
+static void cleanse(mgm &m) {
+    OPENSSL_cleanse(m.keys, sizeof(m.keys));
+    OPENSSL_cleanse(&m.y, sizeof(m.y));
+    OPENSSL_cleanse(&m.z, sizeof(m.z));
+    OPENSSL_cleanse(&m.sum, sizeof(m.sum));
+    OPENSSL_cleanse(&m.buffer, sizeof(m.buffer));
+    OPENSSL_cleanse(&m.gamma, sizeof(m.gamma));
+}
+
+static void cleanse(omac &m) {
+    OPENSSL_cleanse(m.keys, sizeof(m.keys));
+    OPENSSL_cleanse(&m.k1, sizeof(m.k1));
+    OPENSSL_cleanse(&m.k2, sizeof(m.k2));
+    OPENSSL_cleanse(&m.chain, sizeof(m.chain));
+    OPENSSL_cleanse(&m.buffer, sizeof(m.buffer));
+}
+
+// Mode objects hold round keys and keystream, they are wiped whenever they
+// are replaced or the context goes away.
+template <typename T>
+struct cleansing_delete {
+    void operator()(T* p) const {
+        cleanse(*p);
+        delete p;
+    }
+};
+
+template <typename T>
+using mode_ptr = std::unique_ptr<T, cleansing_delete<T>>;
+
+struct cipher_ctx {
+    provider_ctx* prov;
+    cipher_mode mode;
+    bool encrypting = true;
+    bool padding = true;
+    bool key_set = false;
+    bool iv_set = false;
+    std::pair<block128, block128> key;
+    block128 iv = block128(uint64_t{0});
+    std::size_t section_bytes = DEFAULT_SECTION_BYTES;
+
+    block128 keys[11];
+    block128 dec_keys[11];
+    mode_ptr<iov_cbc> cbc;
+    mode_ptr<ctr_acpkm> ctr;
+    mode_ptr<iov_ctr> ctr_stream;
+    mode_ptr<mgm> aead;
+    bool aead_started = false;
+
+    block128 buffer;
+    std::size_t buffered = 0;
+
+    uint8_t tag[16];
+    std::size_t tag_len = 16;
+    bool tag_set = false;
+};
+
+static std::size_t block_size(cipher_mode mode) {
+    return mode == MODE_ECB || mode == MODE_CBC ? 16 : 1;
+}
+
+static std::size_t iv_len(cipher_mode mode) {
+    switch (mode) {
+        case MODE_ECB:
+            return 0;
+        case MODE_CTR:
+        case MODE_CTR_ACPKM:
+            return 8;
+        default:
+            return 16;
+    }
+}
+
+static unsigned int evp_mode(cipher_mode mode) {
+    switch (mode) {
+        case MODE_ECB:
+            return EVP_CIPH_ECB_MODE;
+        case MODE_CBC:
+            return EVP_CIPH_CBC_MODE;
+        case MODE_MGM:
+            return EVP_CIPH_STREAM_CIPHER;
+        default:
+            return EVP_CIPH_CTR_MODE;
+    }
+}
+
+static std::pair<block128, block128> key_from_bytes(const unsigned char* key) {
+    std::pair<block128, block128> res;
+    std::memcpy(res.first.a.data(), key, 16);
+    std::memcpy(res.second.a.data(), key + 16, 16);
+    return res;
+}
+
+static void cipher_setup(cipher_ctx* c) {
+    kuznyechik &cipher = c->prov->cipher;
+    c->buffered = 0;
+    if (!c->key_set) {
+        return;
+    }
+    switch (c->mode) {
+        case MODE_ECB:
+            cipher.expand_key(c->key, c->keys);
+            cipher.expand_decryption_keys(c->keys, c->dec_keys);
+            break;
+        case MODE_CBC:
+            if (c->iv_set) {
+                c->cbc.reset(new iov_cbc(cipher, c->key, c->iv));
+            }
+            break;
+        case MODE_CTR:
+        case MODE_CTR_ACPKM:
+            if (c->iv_set) {
+                std::size_t section_blocks = c->mode == MODE_CTR ? 0 : c->section_bytes / 16;
+                c->ctr.reset(new ctr_acpkm(cipher, c->key, load_be64(c->iv.a.data()), section_blocks));
+                c->ctr_stream.reset(new iov_ctr(*c->ctr));
+            }
+            break;
+        case MODE_MGM:
+            if (!c->aead) {
+                c->aead.reset(new mgm(cipher, c->key));
+            }
+            // without an unused IV the message cannot (re)start
+            c->aead_started = c->iv_set;
+            if (c->iv_set) {
+                c->aead->start(c->iv);
+            }
+            break;
+    }
+}
+
+static bool cipher_ready(cipher_ctx* c) {
+    switch (c->mode) {
+        case MODE_ECB:
+            return c->key_set;
+        case MODE_CBC:
+            return c->cbc != nullptr;
+        case MODE_CTR:
+        case MODE_CTR_ACPKM:
+            return c->ctr_stream != nullptr;
+        case MODE_MGM:
+            return c->aead != nullptr && c->aead_started;
+    }
+    return false;
+}
+
+// ECB and CBC work on whole blocks, partial ones are kept in c->buffer.
+static void process_blocks(cipher_ctx* c, const unsigned char* in, unsigned char* out, std::size_t blocks) {
+    kuznyechik &cipher = c->prov->cipher;
+    if (c->mode == MODE_CBC) {
+        iovec src = {const_cast<unsigned char*>(in), blocks * 16};
+        iovec dst = {out, blocks * 16};
+        if (c->encrypting) {
+            c->cbc->encrypt(&src, 1, &dst, 1);
+        } else {
+            c->cbc->decrypt(&src, 1, &dst, 1);
+        }
+        return;
+    }
+
+    block128 batch[4 * kuznyechik::BATCH_BLOCKS];
+    while (blocks > 0) {
+        std::size_t n = std::min(blocks, 4 * kuznyechik::BATCH_BLOCKS);
+        for (std::size_t i = 0; i < n; i++) {
+            std::memcpy(batch[i].a.data(), in + 16 * i, 16);
+        }
+        if (c->encrypting) {
+            cipher.encrypt_blocks(batch, n, c->keys);
+        } else {
+            cipher.decrypt_blocks(batch, n, c->keys, c->dec_keys);
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            std::memcpy(out + 16 * i, batch[i].a.data(), 16);
+        }
+        in += 16 * n;
+        out += 16 * n;
+        blocks -= n;
+    }
+}
+
+static int block_update(cipher_ctx* c, unsigned char* out, size_t* outl, size_t outsize,
+                        const unsigned char* in, size_t inl) {
+    // with padding the last decrypted block has to wait for final
+    bool hold_last = !c->encrypting && c->padding;
+    std::size_t total = c->buffered + inl;
+    std::size_t out_blocks = total / 16;
+    if (hold_last && total % 16 == 0 && out_blocks > 0) {
+        out_blocks--;
+    }
+    if (out_blocks * 16 > outsize) {
+        return 0;
+    }
+    *outl = out_blocks * 16;
+
+    if (c->buffered > 0 && out_blocks > 0) {
+        std::size_t n = 16 - c->buffered;
+        std::memcpy(c->buffer.a.data() + c->buffered, in, n);
+        process_blocks(c, c->buffer.a.data(), out, 1);
+        c->buffered = 0;
+        in += n;
+        inl -= n;
+        out += 16;
+        out_blocks--;
+    }
+    if (out_blocks > 0) {
+        process_blocks(c, in, out, out_blocks);
+        in += 16 * out_blocks;
+        inl -= 16 * out_blocks;
+    }
+    std::memcpy(c->buffer.a.data() + c->buffered, in, inl);
+    c->buffered += inl;
+    return 1;
+}
+
+static int block_final(cipher_ctx* c, unsigned char* out, size_t* outl, size_t outsize) {
+    *outl = 0;
+    if (!c->padding) {
+        return c->buffered == 0;
+    }
+    if (outsize < 16 && c->encrypting) {
+        return 0;
+    }
+    if (c->encrypting) {
+        uint8_t pad = static_cast<uint8_t>(16 - c->buffered);
+        std::fill(c->buffer.a.begin() + c->buffered, c->buffer.a.end(), pad);
+        process_blocks(c, c->buffer.a.data(), out, 1);
+        c->buffered = 0;
+        *outl = 16;
+        return 1;
+    }
+
+    if (c->buffered != 16) {
+        return 0;
+    }
+    unsigned char last[16];
+    process_blocks(c, c->buffer.a.data(), last, 1);
+    c->buffered = 0;
+    uint8_t pad = last[15];
+    if (pad == 0 || pad > 16 || outsize < 16u - pad) {
+        return 0;
+    }
+    for (std::size_t i = 16 - pad; i < 16; i++) {
+        if (last[i] != pad) {
+            return 0;
+        }
+    }
+    std::memcpy(out, last, 16 - pad);
+    *outl = 16 - pad;
+    return 1;
+}
+
+static int cipher_set_ctx_params(void* vctx, const OSSL_PARAM params[]) {
+    cipher_ctx* c = static_cast<cipher_ctx*>(vctx);
+    if (params == nullptr) {
+        return 1;
+    }
+    const OSSL_PARAM* p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_PADDING);
+    if (p != nullptr) {
+        unsigned int padding;
+        if (!OSSL_PARAM_get_uint(p, &padding)) {
+            return 0;
+        }
+        c->padding = padding != 0;
+    }
+    p = OSSL_PARAM_locate_const(params, KUZNYECHIK_PARAM_KEY_MESH);
+    if (p != nullptr) {
+        std::size_t section_bytes;
+        if (c->mode != MODE_CTR_ACPKM || !OSSL_PARAM_get_size_t(p, &section_bytes) ||
+            section_bytes == 0 || section_bytes % 16 != 0) {
+            return 0;
+        }
+        if (section_bytes != c->section_bytes) {
+            c->section_bytes = section_bytes;
+            cipher_setup(c);
+        }
+    }
+    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TAG);
+    if (p != nullptr) {
+        if (c->mode != MODE_MGM || p->data_type != OSSL_PARAM_OCTET_STRING ||
+            p->data_size == 0 || p->data_size > 16) {
+            return 0;
+        }
+        c->tag_len = p->data_size;
+        if (p->data != nullptr) {
+            if (c->encrypting) {
+                return 0;
+            }
+            std::memcpy(c->tag, p->data, p->data_size);
+            c->tag_set = true;
+        }
+    }
+    return 1;
+}
+
+static int cipher_get_ctx_params(void* vctx, OSSL_PARAM params[]) {
+    cipher_ctx* c = static_cast<cipher_ctx*>(vctx);
+    OSSL_PARAM* p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+    if (p != nullptr && !OSSL_PARAM_set_size_t(p, KEY_LEN)) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+    if (p != nullptr && !OSSL_PARAM_set_size_t(p, iv_len(c->mode))) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_PADDING);
+    if (p != nullptr && !OSSL_PARAM_set_uint(p, c->padding)) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, KUZNYECHIK_PARAM_KEY_MESH);
+    if (p != nullptr && !OSSL_PARAM_set_size_t(p, c->section_bytes)) {
+        return 0;
+    }
+    if (c->mode == MODE_MGM) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAGLEN);
+        if (p != nullptr && !OSSL_PARAM_set_size_t(p, c->tag_len)) {
+            return 0;
+        }
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAG);
+        if (p != nullptr) {
+            if (!c->encrypting || !c->tag_set || p->data_size == 0 || p->data_size > 16 ||
+                !OSSL_PARAM_set_octet_string(p, c->tag, p->data_size)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static const OSSL_PARAM* cipher_gettable_ctx_params(void*, void*) {
+    static const OSSL_PARAM params[] = {
+            OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, nullptr),
+            OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, nullptr),
+            OSSL_PARAM_uint(OSSL_CIPHER_PARAM_PADDING, nullptr),
+            OSSL_PARAM_size_t(KUZNYECHIK_PARAM_KEY_MESH, nullptr),
+            OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_AEAD_TAGLEN, nullptr),
+            OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, nullptr, 0),
+            OSSL_PARAM_END
+    };
+    return params;
+}
+
+static const OSSL_PARAM* cipher_settable_ctx_params(void*, void*) {
+    static const OSSL_PARAM params[] = {
+            OSSL_PARAM_uint(OSSL_CIPHER_PARAM_PADDING, nullptr),
+            OSSL_PARAM_size_t(KUZNYECHIK_PARAM_KEY_MESH, nullptr),
+            OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, nullptr, 0),
+            OSSL_PARAM_END
+    };
+    return params;
+}
+
+static const OSSL_PARAM* cipher_gettable_params(void*) {
+    static const OSSL_PARAM params[] = {
+            OSSL_PARAM_uint(OSSL_CIPHER_PARAM_MODE, nullptr),
+            OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, nullptr),
+            OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, nullptr),
+            OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_BLOCK_SIZE, nullptr),
+            OSSL_PARAM_int(OSSL_CIPHER_PARAM_AEAD, nullptr),
+            OSSL_PARAM_END
+    };
+    return params;
+}
+
+template <cipher_mode MODE>
+static int cipher_get_params(OSSL_PARAM params[]) {
+    OSSL_PARAM* p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_MODE);
+    if (p != nullptr && !OSSL_PARAM_set_uint(p, evp_mode(MODE))) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+    if (p != nullptr && !OSSL_PARAM_set_size_t(p, KEY_LEN)) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+    if (p != nullptr && !OSSL_PARAM_set_size_t(p, iv_len(MODE))) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_BLOCK_SIZE);
+    if (p != nullptr && !OSSL_PARAM_set_size_t(p, block_size(MODE))) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD);
+    if (p != nullptr && !OSSL_PARAM_set_int(p, MODE == MODE_MGM)) {
+        return 0;
+    }
+    return 1;
+}
+
+template <cipher_mode MODE>
+static void* cipher_newctx(void* provctx) {
+    cipher_ctx* c = new cipher_ctx();
+    c->prov = static_cast<provider_ctx*>(provctx);
+    c->mode = MODE;
+    c->padding = block_size(MODE) == 16;
+    return c;
+}
+
+static void cipher_freectx(void* vctx) {
+    cipher_ctx* c = static_cast<cipher_ctx*>(vctx);
+    OPENSSL_cleanse(c->keys, sizeof(c->keys));
+    OPENSSL_cleanse(c->dec_keys, sizeof(c->dec_keys));
+    OPENSSL_cleanse(&c->key, sizeof(c->key));
+    OPENSSL_cleanse(&c->buffer, sizeof(c->buffer));
+    delete c;
+}
+
+static void* cipher_dupctx(void* vctx) {
+    cipher_ctx* src = static_cast<cipher_ctx*>(vctx);
+    cipher_ctx* c = new cipher_ctx();
+    c->prov = src->prov;
+    c->mode = src->mode;
+    c->encrypting = src->encrypting;
+    c->padding = src->padding;
+    c->key_set = src->key_set;
+    c->iv_set = src->iv_set;
+    c->key = src->key;
+    c->iv = src->iv;
+    c->section_bytes = src->section_bytes;
+    std::copy(src->keys, src->keys + 11, c->keys);
+    std::copy(src->dec_keys, src->dec_keys + 11, c->dec_keys);
+    if (src->cbc) {
+        c->cbc.reset(new iov_cbc(*src->cbc));
+    }
+    if (src->ctr) {
+        // the stream refers to its ctr_acpkm, so it is rebuilt on the copy
+        c->ctr.reset(new ctr_acpkm(*src->ctr));
+        c->ctr_stream.reset(new iov_ctr(*c->ctr));
+        c->ctr_stream->gamma = src->ctr_stream->gamma;
+        c->ctr_stream->gamma_used = src->ctr_stream->gamma_used;
+    }
+    if (src->aead) {
+        c->aead.reset(new mgm(*src->aead));
+    }
+    c->aead_started = src->aead_started;
+    c->buffer = src->buffer;
+    c->buffered = src->buffered;
+    std::copy(src->tag, src->tag + 16, c->tag);
+    c->tag_len = src->tag_len;
+    c->tag_set = src->tag_set;
+    return c;
+}
+
+static int cipher_init(void* vctx, const unsigned char* key, size_t keylen,
+                       const unsigned char* iv, size_t ivlen, const OSSL_PARAM params[], bool encrypting) {
+    cipher_ctx* c = static_cast<cipher_ctx*>(vctx);
+    c->encrypting = encrypting;
+    if (key != nullptr) {
+        if (keylen != KEY_LEN) {
+            return 0;
+        }
+        c->key = key_from_bytes(key);
+        c->key_set = true;
+        c->aead.reset();
+    }
+    if (iv != nullptr && iv_len(c->mode) > 0) {
+        if (ivlen != iv_len(c->mode)) {
+            return 0;
+        }
+        c->iv.a.fill(0);
+        std::memcpy(c->iv.a.data(), iv, ivlen);
+        c->iv_set = true;
+        c->tag_set = false;
+    }
+    if (!cipher_set_ctx_params(c, params)) {
+        return 0;
+    }
+    cipher_setup(c);
+    return 1;
+}
+
+static int cipher_encrypt_init(void* vctx, const unsigned char* key, size_t keylen,
+                               const unsigned char* iv, size_t ivlen, const OSSL_PARAM params[]) {
+    return cipher_init(vctx, key, keylen, iv, ivlen, params, true);
+}
+
+static int cipher_decrypt_init(void* vctx, const unsigned char* key, size_t keylen,
+                               const unsigned char* iv, size_t ivlen, const OSSL_PARAM params[]) {
+    return cipher_init(vctx, key, keylen, iv, ivlen, params, false);
+}
+
+static int cipher_update(void* vctx, unsigned char* out, size_t* outl, size_t outsize,
+                         const unsigned char* in, size_t inl) {
+    cipher_ctx* c = static_cast<cipher_ctx*>(vctx);
+    if (!cipher_ready(c)) {
+        return 0;
+    }
+    switch (c->mode) {
+        case MODE_ECB:
+        case MODE_CBC:
+            return block_update(c, out, outl, outsize, in, inl);
+        case MODE_CTR:
+        case MODE_CTR_ACPKM: {
+            if (outsize < inl) {
+                return 0;
+            }
+            iovec src = {const_cast<unsigned char*>(in), inl};
+            iovec dst = {out, inl};
+            c->ctr_stream->apply(&src, 1, &dst, 1);
+            *outl = inl;
+            return 1;
+        }
+        case MODE_MGM:
+            // the nonce is spent once it encrypted anything, a re-init
+            // without a new IV must not start over with it
+            if (c->encrypting) {
+                c->iv_set = false;
+            }
+            if (out == nullptr) {
+                if (c->aead->text_started) {
+                    return 0;
+                }
+                c->aead->update_aad(in, inl);
+            } else {
+                if (outsize < inl) {
+                    return 0;
+                }
+                if (c->encrypting) {
+                    c->aead->encrypt(in, out, inl);
+                } else {
+                    c->aead->decrypt(in, out, inl);
+                }
+            }
+            *outl = inl;
+            return 1;
+    }
+    return 0;
+}
+
+static int cipher_final(void* vctx, unsigned char* out, size_t* outl, size_t outsize) {
+    cipher_ctx* c = static_cast<cipher_ctx*>(vctx);
+    if (!cipher_ready(c)) {
+        return 0;
+    }
+    *outl = 0;
+    switch (c->mode) {
+        case MODE_ECB:
+        case MODE_CBC:
+            return block_final(c, out, outl, outsize);
+        case MODE_CTR:
+        case MODE_CTR_ACPKM:
+            return 1;
+        case MODE_MGM: {
+            block128 tag = c->aead->finalize();
+            c->aead_started = false;
+            if (c->encrypting) {
+                // a nonce must never encrypt twice, the next message needs a new IV
+                c->iv_set = false;
+                std::memcpy(c->tag, tag.a.data(), 16);
+                c->tag_set = true;
+                return 1;
+            }
+            if (!c->tag_set) {
+                return 0;
+            }
+            uint8_t diff = 0;
+            for (std::size_t i = 0; i < c->tag_len; i++) {
+                diff |= c->tag[i] ^ tag.a[i];
+            }
+            return diff == 0;
+        }
+    }
+    return 0;
+}
+
+static int cipher_cipher(void* vctx, unsigned char* out, size_t* outl, size_t outsize,
+                         const unsigned char* in, size_t inl) {
+    cipher_ctx* c = static_cast<cipher_ctx*>(vctx);
+    if (c->mode != MODE_ECB && c->mode != MODE_CBC) {
+        return cipher_update(vctx, out, outl, outsize, in, inl);
+    }
+    if (!cipher_ready(c) || inl % 16 != 0 || outsize < inl) {
+        return 0;
+    }
+    process_blocks(c, in, out, inl / 16);
+    *outl = inl;
+    return 1;
+}
+
+template <cipher_mode MODE>
+static const OSSL_DISPATCH cipher_functions[] = {
+        {OSSL_FUNC_CIPHER_NEWCTX, (void (*)(void)) cipher_newctx<MODE>},
+        {OSSL_FUNC_CIPHER_DUPCTX, (void (*)(void)) cipher_dupctx},
+        {OSSL_FUNC_CIPHER_FREECTX, (void (*)(void)) cipher_freectx},
+        {OSSL_FUNC_CIPHER_ENCRYPT_INIT, (void (*)(void)) cipher_encrypt_init},
+        {OSSL_FUNC_CIPHER_DECRYPT_INIT, (void (*)(void)) cipher_decrypt_init},
+        {OSSL_FUNC_CIPHER_UPDATE, (void (*)(void)) cipher_update},
+        {OSSL_FUNC_CIPHER_FINAL, (void (*)(void)) cipher_final},
+        {OSSL_FUNC_CIPHER_CIPHER, (void (*)(void)) cipher_cipher},
+        {OSSL_FUNC_CIPHER_GET_PARAMS, (void (*)(void)) cipher_get_params<MODE>},
+        {OSSL_FUNC_CIPHER_GETTABLE_PARAMS, (void (*)(void)) cipher_gettable_params},
+        {OSSL_FUNC_CIPHER_GET_CTX_PARAMS, (void (*)(void)) cipher_get_ctx_params},
+        {OSSL_FUNC_CIPHER_GETTABLE_CTX_PARAMS, (void (*)(void)) cipher_gettable_ctx_params},
+        {OSSL_FUNC_CIPHER_SET_CTX_PARAMS, (void (*)(void)) cipher_set_ctx_params},
+        {OSSL_FUNC_CIPHER_SETTABLE_CTX_PARAMS, (void (*)(void)) cipher_settable_ctx_params},
+        {0, nullptr}
+};
+
+struct mac_ctx {
+    provider_ctx* prov;
+    mode_ptr<omac> mac;
+    std::size_t size = 16;
+};
+
+static void* mac_newctx(void* provctx) {
+    mac_ctx* m = new mac_ctx();
+    m->prov = static_cast<provider_ctx*>(provctx);
+    return m;
+}
+
+static void mac_freectx(void* vctx) {
+    delete static_cast<mac_ctx*>(vctx);
+}
+
+static void* mac_dupctx(void* vctx) {
+    mac_ctx* src = static_cast<mac_ctx*>(vctx);
+    mac_ctx* m = new mac_ctx();
+    m->prov = src->prov;
+    m->size = src->size;
+    if (src->mac) {
+        m->mac.reset(new omac(*src->mac));
+    }
+    return m;
+}
+
+static int mac_set_key(mac_ctx* m, const unsigned char* key, size_t keylen) {
+    if (keylen != KEY_LEN) {
+        return 0;
+    }
+    m->mac.reset(new omac(m->prov->cipher, key_from_bytes(key)));
+    return 1;
+}
+
+static int mac_set_ctx_params(void* vctx, const OSSL_PARAM params[]) {
+    mac_ctx* m = static_cast<mac_ctx*>(vctx);
+    if (params == nullptr) {
+        return 1;
+    }
+    const OSSL_PARAM* p = OSSL_PARAM_locate_const(params, OSSL_MAC_PARAM_SIZE);
+    if (p != nullptr) {
+        std::size_t size;
+        if (!OSSL_PARAM_get_size_t(p, &size) || size == 0 || size > 16) {
+            return 0;
+        }
+        m->size = size;
+    }
+    p = OSSL_PARAM_locate_const(params, OSSL_MAC_PARAM_KEY);
+    if (p != nullptr) {
+        if (p->data_type != OSSL_PARAM_OCTET_STRING ||
+            !mac_set_key(m, static_cast<const unsigned char*>(p->data), p->data_size)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int mac_get_ctx_params(void* vctx, OSSL_PARAM params[]) {
+    mac_ctx* m = static_cast<mac_ctx*>(vctx);
+    OSSL_PARAM* p = OSSL_PARAM_locate(params, OSSL_MAC_PARAM_SIZE);
+    if (p != nullptr && !OSSL_PARAM_set_size_t(p, m->size)) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_MAC_PARAM_BLOCK_SIZE);
+    if (p != nullptr && !OSSL_PARAM_set_size_t(p, 16)) {
+        return 0;
+    }
+    return 1;
+}
+
+static const OSSL_PARAM* mac_gettable_ctx_params(void*, void*) {
+    static const OSSL_PARAM params[] = {
+            OSSL_PARAM_size_t(OSSL_MAC_PARAM_SIZE, nullptr),
+            OSSL_PARAM_size_t(OSSL_MAC_PARAM_BLOCK_SIZE, nullptr),
+            OSSL_PARAM_END
+    };
+    return params;
+}
+
+static const OSSL_PARAM* mac_settable_ctx_params(void*, void*) {
+    static const OSSL_PARAM params[] = {
+            OSSL_PARAM_size_t(OSSL_MAC_PARAM_SIZE, nullptr),
+            OSSL_PARAM_octet_string(OSSL_MAC_PARAM_KEY, nullptr, 0),
+            OSSL_PARAM_END
+    };
+    return params;
+}
+
+static int mac_init(void* vctx, const unsigned char* key, size_t keylen, const OSSL_PARAM params[]) {
+    mac_ctx* m = static_cast<mac_ctx*>(vctx);
+    if (!mac_set_ctx_params(m, params)) {
+        return 0;
+    }
+    if (key != nullptr) {
+        return mac_set_key(m, key, keylen);
+    }
+    if (!m->mac) {
+        return 0;
+    }
+    m->mac->reset();
+    return 1;
+}
+
+static int mac_update(void* vctx, const unsigned char* in, size_t inl) {
+    mac_ctx* m = static_cast<mac_ctx*>(vctx);
+    if (!m->mac) {
+        return 0;
+    }
+    m->mac->update(in, inl);
+    return 1;
+}
+
+static int mac_final(void* vctx, unsigned char* out, size_t* outl, size_t outsize) {
+    mac_ctx* m = static_cast<mac_ctx*>(vctx);
+    if (!m->mac || outsize < m->size) {
+        return 0;
+    }
+    block128 tag = m->mac->finalize();
+    std::memcpy(out, tag.a.data(), m->size);
+    *outl = m->size;
+    return 1;
+}
+
+static const OSSL_DISPATCH mac_functions[] = {
+        {OSSL_FUNC_MAC_NEWCTX, (void (*)(void)) mac_newctx},
+        {OSSL_FUNC_MAC_DUPCTX, (void (*)(void)) mac_dupctx},
+        {OSSL_FUNC_MAC_FREECTX, (void (*)(void)) mac_freectx},
+        {OSSL_FUNC_MAC_INIT, (void (*)(void)) mac_init},
+        {OSSL_FUNC_MAC_UPDATE, (void (*)(void)) mac_update},
+        {OSSL_FUNC_MAC_FINAL, (void (*)(void)) mac_final},
+        {OSSL_FUNC_MAC_GET_CTX_PARAMS, (void (*)(void)) mac_get_ctx_params},
+        {OSSL_FUNC_MAC_GETTABLE_CTX_PARAMS, (void (*)(void)) mac_gettable_ctx_params},
+        {OSSL_FUNC_MAC_SET_CTX_PARAMS, (void (*)(void)) mac_set_ctx_params},
+        {OSSL_FUNC_MAC_SETTABLE_CTX_PARAMS, (void (*)(void)) mac_settable_ctx_params},
+        {0, nullptr}
+};
+
+static const OSSL_ALGORITHM ciphers[] = {
+        {"kuznyechik-ecb", "provider=kuznyechik", cipher_functions<MODE_ECB>, "Kuznyechik ECB"},
+        {"kuznyechik-cbc", "provider=kuznyechik", cipher_functions<MODE_CBC>, "Kuznyechik CBC"},
+        {"kuznyechik-ctr", "provider=kuznyechik", cipher_functions<MODE_CTR>, "Kuznyechik CTR"},
+        {"kuznyechik-ctr-acpkm", "provider=kuznyechik", cipher_functions<MODE_CTR_ACPKM>, "Kuznyechik CTR-ACPKM"},
+        {"kuznyechik-mgm", "provider=kuznyechik", cipher_functions<MODE_MGM>, "Kuznyechik MGM"},
+        {nullptr, nullptr, nullptr, nullptr}
+};
+
+static const OSSL_ALGORITHM macs[] = {
+        {"kuznyechik-mac", "provider=kuznyechik", mac_functions, "Kuznyechik OMAC"},
+        {nullptr, nullptr, nullptr, nullptr}
+};
+
+static const OSSL_ALGORITHM* provider_query(void*, int operation_id, int* no_cache) {
+    *no_cache = 0;
+    switch (operation_id) {
+        case OSSL_OP_CIPHER:
+            return ciphers;
+        case OSSL_OP_MAC:
+            return macs;
+        default:
+            return nullptr;
+    }
+}
+
+static const OSSL_PARAM* provider_gettable_params(void*) {
+    static const OSSL_PARAM params[] = {
+            OSSL_PARAM_utf8_ptr(OSSL_PROV_PARAM_NAME, nullptr, 0),
+            OSSL_PARAM_utf8_ptr(OSSL_PROV_PARAM_VERSION, nullptr, 0),
+            OSSL_PARAM_utf8_ptr(OSSL_PROV_PARAM_BUILDINFO, nullptr, 0),
+            OSSL_PARAM_int(OSSL_PROV_PARAM_STATUS, nullptr),
+            OSSL_PARAM_END
+    };
+    return params;
+}
+
+static int provider_get_params(void*, OSSL_PARAM params[]) {
+    OSSL_PARAM* p = OSSL_PARAM_locate(params, OSSL_PROV_PARAM_NAME);
+    if (p != nullptr && !OSSL_PARAM_set_utf8_ptr(p, "Kuznyechik provider")) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_PROV_PARAM_VERSION);
+    if (p != nullptr && !OSSL_PARAM_set_utf8_ptr(p, "1.0")) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_PROV_PARAM_BUILDINFO);
+    if (p != nullptr && !OSSL_PARAM_set_utf8_ptr(p, "1.0")) {
+        return 0;
+    }
+    p = OSSL_PARAM_locate(params, OSSL_PROV_PARAM_STATUS);
+    if (p != nullptr && !OSSL_PARAM_set_int(p, 1)) {
+        return 0;
+    }
+    return 1;
+}
+
+static void provider_teardown(void* provctx) {
+    delete static_cast<provider_ctx*>(provctx);
+}
+
+static const OSSL_DISPATCH provider_functions[] = {
+        {OSSL_FUNC_PROVIDER_TEARDOWN, (void (*)(void)) provider_teardown},
+        {OSSL_FUNC_PROVIDER_QUERY_OPERATION, (void (*)(void)) provider_query},
+        {OSSL_FUNC_PROVIDER_GETTABLE_PARAMS, (void (*)(void)) provider_gettable_params},
+        {OSSL_FUNC_PROVIDER_GET_PARAMS, (void (*)(void)) provider_get_params},
+        {0, nullptr}
+};
+
+extern "C" int OSSL_provider_init(const OSSL_CORE_HANDLE* handle, const OSSL_DISPATCH*,
+                                  const OSSL_DISPATCH** out, void** provctx) {
+    provider_ctx* ctx = new provider_ctx();
+    ctx->handle = handle;
+    *provctx = ctx;
+    *out = provider_functions;
+    return 1;
+}
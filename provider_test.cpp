@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/provider.h>
+
+// Checks the provider module through the EVP interface, the only argument is
+// the directory the module was built into.
+
+static const std::string KEY = "8899aabbccddeeff0011223344556677fedcba98765432100123456789abcdef";
+static const std::string PLAIN = "1122334455667700ffeeddccbbaa9988"
+                                 "00112233445566778899aabbcceeff0a"
+                                 "112233445566778899aabbcceeff0a00"
+                                 "2233445566778899aabbcceeff0a0011";
+
+std::vector<unsigned char> from_hex(const std::string &s) {
+    std::vector<unsigned char> res;
+    for (std::size_t i = 0; i < s.size(); i += 2) {
+        res.push_back(static_cast<unsigned char>(std::stoi(s.substr(i, 2), nullptr, 16)));
+    }
+    return res;
+}
+
+std::string to_hex(const unsigned char* data, std::size_t len) {
+    static const char* digits = "0123456789abcdef";
+    std::string res;
+    for (std::size_t i = 0; i < len; i++) {
+        res += digits[data[i] >> 4];
+        res += digits[data[i] & 15];
+    }
+    return res;
+}
+
+// Runs the whole input through EVP in uneven pieces and returns hex output,
+// or an empty string on failure.
+std::string run_cipher(const char* name, bool encrypt, const std::string &iv, const std::string &in,
+                       bool padding, const OSSL_PARAM* params = nullptr) {
+    EVP_CIPHER* cipher = EVP_CIPHER_fetch(nullptr, name, "provider=kuznyechik");
+    if (cipher == nullptr) {
+        return "";
+    }
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    auto key = from_hex(KEY), ivb = from_hex(iv), data = from_hex(in);
+    std::vector<unsigned char> out(data.size() + 32);
+    int len = 0, total = 0;
+    bool ok = EVP_CipherInit_ex2(ctx, cipher, key.data(), ivb.empty() ? nullptr : ivb.data(), encrypt, params) &&
+              EVP_CIPHER_CTX_set_padding(ctx, padding);
+    for (std::size_t pos = 0, chunk = 1; ok && pos < data.size(); pos += chunk, chunk = chunk * 5 % 23 + 1) {
+        chunk = std::min(chunk, data.size() - pos);
+        ok = EVP_CipherUpdate(ctx, out.data() + total, &len, data.data() + pos, (int) chunk);
+        total += len;
+    }
+    ok = ok && EVP_CipherFinal_ex(ctx, out.data() + total, &len);
+    total += len;
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(cipher);
+    return ok ? to_hex(out.data(), total) : "";
+}
+
+bool test_ecb() {
+    return run_cipher("kuznyechik-ecb", true, "", PLAIN.substr(0, 32), false) == "7f679d90bebc24305a468d42b9d4edcd" &&
+           run_cipher("kuznyechik-ecb", false, "", "7f679d90bebc24305a468d42b9d4edcd", false) == PLAIN.substr(0, 32);
+}
+
+bool test_cbc() {
+    std::string iv = "1234567890abcef0a1b2c3d4e5f00112";
+    std::string in = PLAIN.substr(0, 74);
+    std::string out = run_cipher("kuznyechik-cbc", true, iv, in, true);
+    if (out.size() != 96) {
+        return false;
+    }
+    auto first = from_hex(PLAIN.substr(0, 32)), ivb = from_hex(iv);
+    for (std::size_t i = 0; i < 16; i++) {
+        first[i] ^= ivb[i];
+    }
+    return run_cipher("kuznyechik-ecb", true, "", to_hex(first.data(), 16), false) == out.substr(0, 32) &&
+           run_cipher("kuznyechik-cbc", false, iv, out, true) == in;
+}
+
+bool test_ctr() {
+    std::string out = run_cipher("kuznyechik-ctr", true, "1234567890abcef0", PLAIN, false);
+    return out.substr(0, 64) == "f195d8bec10ed1dbd57b5fa240bda1b885eee733f6a13e5df33ce4b33c45dee4" &&
+           run_cipher("kuznyechik-ctr", false, "1234567890abcef0", out.substr(0, 102), false) == PLAIN.substr(0, 102);
+}
+
+bool test_ctr_acpkm() {
+    size_t section = 32;
+    OSSL_PARAM params[] = {OSSL_PARAM_size_t("key-mesh", &section), OSSL_PARAM_END};
+    std::string out = run_cipher("kuznyechik-ctr-acpkm", true, "1234567890abcef0", PLAIN, false, params);
+    return out.substr(0, 96) == "f195d8bec10ed1dbd57b5fa240bda1b885eee733f6a13e5df33ce4b33c45dee4"
+                                "4bceeb8f646f4c55001706275e85e800";
+}
+
+bool run_mgm(bool encrypt, std::vector<unsigned char> &in, std::vector<unsigned char> &out,
+             std::vector<unsigned char> &tag) {
+    auto key = from_hex(KEY), nonce = from_hex("1122334455667700ffeeddccbbaa9988");
+    auto aad = from_hex("0202020202020202010101010101010104040404040404040303030303030303ea0505050505050505");
+    EVP_CIPHER* cipher = EVP_CIPHER_fetch(nullptr, "kuznyechik-mgm", "provider=kuznyechik");
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    out.resize(in.size());
+    int len = 0, total = 0;
+    bool ok = cipher != nullptr && EVP_CipherInit_ex2(ctx, cipher, key.data(), nonce.data(), encrypt, nullptr) &&
+              EVP_CipherUpdate(ctx, nullptr, &len, aad.data(), 20) &&
+              EVP_CipherUpdate(ctx, nullptr, &len, aad.data() + 20, (int) aad.size() - 20) &&
+              EVP_CipherUpdate(ctx, out.data(), &len, in.data(), 33);
+    total += len;
+    ok = ok && EVP_CipherUpdate(ctx, out.data() + total, &len, in.data() + 33, (int) in.size() - 33);
+    if (ok && !encrypt) {
+        OSSL_PARAM params[] = {OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, tag.data(), tag.size()),
+                               OSSL_PARAM_END};
+        ok = EVP_CIPHER_CTX_set_params(ctx, params);
+    }
+    ok = ok && EVP_CipherFinal_ex(ctx, out.data(), &len);
+    if (ok && encrypt) {
+        tag.resize(16);
+        OSSL_PARAM params[] = {OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, tag.data(), tag.size()),
+                               OSSL_PARAM_END};
+        ok = EVP_CIPHER_CTX_get_params(ctx, params);
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(cipher);
+    return ok;
+}
+
+bool test_mgm() {
+    auto plain = from_hex(PLAIN + "aabbcc");
+    std::vector<unsigned char> cipher_text, back, tag;
+    if (!run_mgm(true, plain, cipher_text, tag) ||
+        to_hex(cipher_text.data(), cipher_text.size()) !=
+        "a9757b8147956e9055b8a33de89f42fc8075d2212bf9fd5bd3f7069aadc16b39497ab15915a6ba85936b5d0ea9f6851c"
+        "c60c14d4d3f883d0ab94420695c76deb2c7552" ||
+        to_hex(tag.data(), tag.size()) != "cf5d656f40c34f5c46e8bb0e29fcdb4c") {
+        return false;
+    }
+    if (!run_mgm(false, cipher_text, back, tag) || back != plain) {
+        return false;
+    }
+    cipher_text[5] ^= 1;
+    return !run_mgm(false, cipher_text, back, tag);
+}
+
+// Once an encryption has started the nonce is spent: re-initialising without
+// an IV, mid-message or after final, must not restart the keystream, and a
+// finished message takes no more data.
+bool test_mgm_nonce_reuse() {
+    auto key = from_hex(KEY), nonce = from_hex("1122334455667700ffeeddccbbaa9988"), data = from_hex(PLAIN);
+    EVP_CIPHER* cipher = EVP_CIPHER_fetch(nullptr, "kuznyechik-mgm", "provider=kuznyechik");
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    std::vector<unsigned char> out(data.size());
+    int len = 0;
+    bool ok = cipher != nullptr && EVP_EncryptInit_ex2(ctx, cipher, key.data(), nonce.data(), nullptr) &&
+              EVP_EncryptUpdate(ctx, out.data(), &len, data.data(), (int) data.size()) &&
+              EVP_EncryptFinal_ex(ctx, out.data(), &len);
+    ok = ok && !EVP_EncryptFinal_ex(ctx, out.data(), &len) &&
+         !EVP_EncryptUpdate(ctx, out.data(), &len, data.data(), (int) data.size());
+    ok = ok && EVP_EncryptInit_ex2(ctx, nullptr, nullptr, nullptr, nullptr) &&
+         !EVP_EncryptUpdate(ctx, out.data(), &len, data.data(), (int) data.size());
+    nonce[15] ^= 1;
+    ok = ok && EVP_EncryptInit_ex2(ctx, nullptr, nullptr, nonce.data(), nullptr) &&
+         EVP_EncryptUpdate(ctx, out.data(), &len, data.data(), 32);
+    ok = ok && EVP_EncryptInit_ex2(ctx, nullptr, nullptr, nullptr, nullptr) &&
+         !EVP_EncryptUpdate(ctx, out.data(), &len, data.data(), 32) &&
+         !EVP_EncryptFinal_ex(ctx, out.data(), &len);
+    ok = ok && EVP_EncryptInit_ex2(ctx, nullptr, nullptr, nonce.data(), nullptr) &&
+         EVP_EncryptUpdate(ctx, nullptr, &len, data.data(), 16);
+    ok = ok && EVP_EncryptInit_ex2(ctx, nullptr, nullptr, nullptr, nullptr) &&
+         !EVP_EncryptUpdate(ctx, out.data(), &len, data.data(), 32);
+    nonce[15] ^= 2;
+    ok = ok && EVP_EncryptInit_ex2(ctx, nullptr, nullptr, nonce.data(), nullptr) &&
+         EVP_EncryptUpdate(ctx, out.data(), &len, data.data(), 32);
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(cipher);
+    return ok;
+}
+
+// Copies a context in the middle of a message, frees the original and
+// checks that the copy finishes it exactly like an uninterrupted run.
+bool test_dupctx(const char* name, const std::string &iv, const OSSL_PARAM* params = nullptr) {
+    bool aead = std::string(name) == "kuznyechik-mgm";
+    auto key = from_hex(KEY), ivb = from_hex(iv), data = from_hex(PLAIN + "aabbcc");
+    EVP_CIPHER* cipher = EVP_CIPHER_fetch(nullptr, name, "provider=kuznyechik");
+    std::vector<unsigned char> out[2], tag[2];
+    for (int run = 0; run < 2; run++) {
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+        out[run].resize(data.size() + 16);
+        tag[run].resize(16);
+        int len = 0, total = 0;
+        bool ok = cipher != nullptr && EVP_EncryptInit_ex2(ctx, cipher, key.data(), ivb.data(), params) &&
+                  EVP_EncryptUpdate(ctx, out[run].data(), &len, data.data(), 37);
+        total += len;
+        if (ok && run == 1) {
+            EVP_CIPHER_CTX* copy = EVP_CIPHER_CTX_new();
+            ok = EVP_CIPHER_CTX_copy(copy, ctx);
+            EVP_CIPHER_CTX_free(ctx);
+            ctx = copy;
+        }
+        ok = ok && EVP_EncryptUpdate(ctx, out[run].data() + total, &len, data.data() + 37, (int) data.size() - 37);
+        total += len;
+        ok = ok && EVP_EncryptFinal_ex(ctx, out[run].data() + total, &len);
+        total += len;
+        out[run].resize(total);
+        if (ok && aead) {
+            OSSL_PARAM tag_params[] = {OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, tag[run].data(), 16),
+                                       OSSL_PARAM_END};
+            ok = EVP_CIPHER_CTX_get_params(ctx, tag_params);
+        }
+        EVP_CIPHER_CTX_free(ctx);
+        if (!ok) {
+            EVP_CIPHER_free(cipher);
+            return false;
+        }
+    }
+    EVP_CIPHER_free(cipher);
+    return out[0] == out[1] && tag[0] == tag[1];
+}
+
+bool test_dup() {
+    size_t section = 32;
+    OSSL_PARAM params[] = {OSSL_PARAM_size_t("key-mesh", &section), OSSL_PARAM_END};
+    return test_dupctx("kuznyechik-cbc", "1234567890abcef0a1b2c3d4e5f00112") &&
+           test_dupctx("kuznyechik-ctr-acpkm", "1234567890abcef0", params) &&
+           test_dupctx("kuznyechik-mgm", "1122334455667700ffeeddccbbaa9988");
+}
+
+bool test_mac() {
+    auto key = from_hex(KEY), data = from_hex(PLAIN);
+    EVP_MAC* mac = EVP_MAC_fetch(nullptr, "kuznyechik-mac", "provider=kuznyechik");
+    EVP_MAC_CTX* ctx = mac != nullptr ? EVP_MAC_CTX_new(mac) : nullptr;
+    size_t size = 8;
+    OSSL_PARAM params[] = {OSSL_PARAM_size_t(OSSL_MAC_PARAM_SIZE, &size), OSSL_PARAM_END};
+    unsigned char out[16];
+    size_t len = 0;
+    bool ok = ctx != nullptr && EVP_MAC_init(ctx, key.data(), key.size(), params) &&
+              EVP_MAC_update(ctx, data.data(), 13) &&
+              EVP_MAC_update(ctx, data.data() + 13, data.size() - 13) &&
+              EVP_MAC_final(ctx, out, &len, sizeof(out));
+    EVP_MAC_CTX_free(ctx);
+    EVP_MAC_free(mac);
+    return ok && to_hex(out, len) == "336f4d296059fbe3";
+}
+
+bool check_test_res(std::string name, bool res) {
+    if (!res) {
+        std::cerr << name << ": FAILED!" << std::endl;
+    } else {
+        std::cout << name << ": OK" << std::endl;
+    }
+    return res;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <provider directory>" << std::endl;
+        return 2;
+    }
+    OSSL_PROVIDER_set_default_search_path(nullptr, argv[1]);
+    OSSL_PROVIDER* prov = OSSL_PROVIDER_load(nullptr, "kuznyechik");
+    if (prov == nullptr) {
+        std::cerr << "cannot load provider from " << argv[1] << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    ok &= check_test_res("Provider ECB", test_ecb());
+    ok &= check_test_res("Provider CBC", test_cbc());
+    ok &= check_test_res("Provider CTR", test_ctr());
+    ok &= check_test_res("Provider CTR-ACPKM", test_ctr_acpkm());
+    ok &= check_test_res("Provider MGM", test_mgm());
+    ok &= check_test_res("Provider MGM nonce reuse", test_mgm_nonce_reuse());
+    ok &= check_test_res("Provider context copy", test_dup());
+    ok &= check_test_res("Provider OMAC", test_mac());
+
+    OSSL_PROVIDER_unload(prov);
+    return ok ? 0 : 1;
+}